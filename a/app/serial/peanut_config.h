@@ -3,15 +3,58 @@
 
 /*
  * This is intended to move out into the application.
+ *
+ * Declarative description of the system.  Object Table indices, AppInfo
+ * memory runs, and the kernel's RAM donation are all derived from this (see
+ * a/sys/layout.h), so changing it needn't involve any counting.
  */
 
+#include "a/k/memory.h"
+#include "a/sys/layout.h"
+
 namespace config {
 
 static constexpr unsigned
-  memory_map_count = 3,
+  // Entries in the memory map (see setup.cc): system ROM, system RAM.
+  memory_map_count = 2,
+  // Device entries following them: APB.
   device_map_count = 1,
   extra_slot_count = 20,
-  external_interrupt_count = 40;
+  external_interrupt_count = 40,
+  // Programs that can be loaded (see load.cc), which sys remembers so that it
+  // can reinitialize them after a fault.
+  max_program_count = 4;
+
+// Application RAM: 64 KiB, with four 2 KiB blocks set aside for object bodies
+// and small programs.  The linker script must place it on a 64 KiB boundary.
+static constexpr sys::layout::RamRuns app_ram { 64 * 1024, 10, 4 };
+
+// Objects the kernel makes at boot, in order.  The system relies on the first
+// two.
+static constexpr memory::ObjectType boot_objects[] {
+  memory::ObjectType::gate,  // syscall gate
+  memory::ObjectType::context,  // idle task
+};
+
+static_assert(app_ram.is_valid(), "app_ram can't be expressed as memory runs");
+static_assert(sys::layout::boot_types_valid(boot_objects),
+    "unsupported or too many boot objects");
+
+/*
+ * Derived values.
+ */
+
+static constexpr unsigned
+  memory_run_block_count = app_ram.block_count(),
+  boot_object_count = sizeof(boot_objects) / sizeof(boot_objects[0]);
+
+static constexpr sys::layout::TableLayout table {
+  memory_map_count,
+  device_map_count,
+  memory_run_block_count,
+  boot_object_count,
+  extra_slot_count,
+};
 
 }  // namespace config
 
@@ -52,22 +52,17 @@ constexpr AppInfo::MemoryMapEntry memory_map[] {
     reinterpret_cast<uint32_t>(&_sys_ram0_start),
     reinterpret_cast<uint32_t>(&_sys_ram0_end),
   },
+  // Application RAM is described by memory runs instead; see a/sys/main.cc.
   {
-    // K+2: Memory describing application RAM.
-    reinterpret_cast<uint32_t>(&_app_ram1_start),
-    reinterpret_cast<uint32_t>(&_app_ram1_end),
-  },
-  {
-    // K+3: APB
+    // K+2: APB
     0x40000000,
     0x60000000,
   },
 };
 
 static constexpr unsigned
-  oi_sys_rom = kabi::well_known_object_count + 0,
-  oi_app_ram = kabi::well_known_object_count + 2,
-  oi_apb = kabi::well_known_object_count + 3;
+  oi_sys_rom = config::table.first_memory() + 0,
+  oi_apb = config::table.first_device() + 0;
 
 
 /*******************************************************************************
@@ -78,7 +73,7 @@ static constexpr unsigned
  * Allocates a fresh Gate.
  */
 static rt::AutoKey make_gate() {
-  auto k = etl::move(alloc_mem(kabi::gate_l2_size - 1, 0).ref());
+  auto k = etl::move(alloc_body_mem(kabi::gate_size).ref());
   memory::become(k, memory::ObjectType::gate, 0);
   return k;
 }
@@ -127,7 +122,7 @@ static rt::AutoKey make_uart_driver() {
   // TODO: it's silly that we set the Interrupt target; driver should do it
   // so that it can choose the brand.
   {
-    auto k_irq = etl::move(alloc_mem(kabi::interrupt_l2_size - 1, 0).ref());
+    auto k_irq = etl::move(alloc_body_mem(kabi::interrupt_size).ref());
     memory::become(k_irq, memory::ObjectType::interrupt,
         uint32_t(etl::stm32f4xx::Interrupt::usart2));
     context::set_key(k_prog, 12, k_irq);
@@ -63,6 +63,53 @@ void make_runnable(unsigned k) {
   ETL_ASSERT(!msg.desc.get_error());
 }
 
+void save_restart_state(unsigned k, uint32_t entry_point) {
+  Message msg {
+    Descriptor::call(S::save_restart_state, k),
+    entry_point,
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(!msg.desc.get_error());
+}
+
+bool restart(unsigned k) {
+  Message msg {
+    Descriptor::call(S::restart, k),
+  };
+  rt::ipc2(msg, 0, 0);
+  return !msg.desc.get_error();
+}
+
+void set_supervisor(unsigned k, unsigned supervisor_key) {
+  Message msg {
+    Descriptor::call(S::set_supervisor, k),
+  };
+  rt::ipc2(msg,
+      rt::keymap(0, supervisor_key, 0, 0),
+      0);
+  ETL_ASSERT(!msg.desc.get_error());
+}
+
+void set_region_cache(unsigned k, unsigned region_mask, unsigned keyring_key) {
+  Message msg {
+    Descriptor::call(S::set_region_cache, k),
+    region_mask,
+  };
+  rt::ipc2(msg,
+      rt::keymap(0, keyring_key, 0, 0),
+      0);
+  ETL_ASSERT(!msg.desc.get_error());
+}
+
+Maybe<unsigned> abandon_reply_keys(unsigned k) {
+  Message msg {
+    Descriptor::call(S::abandon_reply_keys, k),
+  };
+  rt::ipc2(msg, 0, 0);
+  if (msg.desc.get_error()) return nothing;
+  return msg.d0;
+}
+
 void set_priority(unsigned k, unsigned priority) {
   Message msg {
     Descriptor::call(S::set_priority, k),
@@ -72,4 +119,14 @@ void set_priority(unsigned k, unsigned priority) {
   ETL_ASSERT(!msg.desc.get_error());
 }
 
+rt::AutoKey destroy(unsigned k) {
+  Message msg {
+    Descriptor::call(S::destroy, k),
+  };
+  auto k_out = rt::AutoKey{};
+  rt::ipc2(msg, 0, rt::keymap(0, k_out, 0, 0));
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return k_out;
+}
+
 }  // namespace context
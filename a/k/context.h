@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include "a/maybe.h"
 #include "a/rt/keys.h"
 
 namespace context {
@@ -22,8 +23,38 @@ void set_key(unsigned k, unsigned key_index, unsigned key);
 
 void make_runnable(unsigned k);
 
+void save_restart_state(unsigned k, uint32_t entry_point);
+
+/*
+ * Restarts the Context in k from its saved restart state.  Returns false if
+ * the kernel refuses, e.g. because k no longer designates a Context, or
+ * designates the caller's own.
+ */
+bool restart(unsigned k);
+
+void set_supervisor(unsigned k, unsigned supervisor_key);
+
+/*
+ * Gives the region registers in 'region_mask' over to a cache, refilled on
+ * demand from the Memory keys in the Keyring in 'keyring_key'.  A mask of zero
+ * disables the cache.
+ */
+void set_region_cache(unsigned k, unsigned region_mask, unsigned keyring_key);
+
+/*
+ * Fails every caller awaiting a reply through a key held in the Context's key
+ * registers, and nulls those registers.  Returns the number of callers
+ * affected, or nothing if k no longer designates a Context.
+ *
+ * Reply keys the Context has moved out of its key registers (into a Keyring,
+ * say) aren't found.
+ */
+Maybe<unsigned> abandon_reply_keys(unsigned k);
+
 void set_priority(unsigned k, unsigned priority);
 
+rt::AutoKey destroy(unsigned k);
+
 }  // namespace context
 
 #endif  // A_K_CONTEXT_H
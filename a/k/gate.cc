@@ -20,4 +20,23 @@ rt::AutoKey make_client_key(unsigned k, Brand brand) {
   return k_out;
 }
 
+Discharged discharge_one(unsigned k) {
+  Message msg {
+    Descriptor::call(S::discharge_one, k),
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return Discharged(msg.d0);
+}
+
+rt::AutoKey destroy(unsigned k) {
+  Message msg {
+    Descriptor::call(S::destroy, k),
+  };
+  auto k_out = rt::AutoKey{};
+  rt::ipc2(msg, 0, rt::keymap(0, k_out, 0, 0));
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return k_out;
+}
+
 }  // namespace gate
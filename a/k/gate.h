@@ -10,6 +10,16 @@ namespace gate {
 
 rt::AutoKey make_client_key(unsigned k, Brand);
 
+enum class Discharged : uint32_t {
+  none = 0,
+  sender = 1,
+  receiver = 2,
+};
+
+Discharged discharge_one(unsigned k);
+
+rt::AutoKey destroy(unsigned k);
+
 }  // namespace gate
 
 #endif  // A_K_GATE_H
@@ -20,4 +20,14 @@ void enable(unsigned k, bool clear_pending) {
   ETL_ASSERT(msg.desc.get_error() == false);
 }
 
+rt::AutoKey destroy(unsigned k) {
+  Message msg {
+    Descriptor::call(S::destroy, k),
+  };
+  auto k_out = rt::AutoKey{};
+  rt::ipc2(msg, 0, rt::keymap(0, k_out, 0, 0));
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return k_out;
+}
+
 }  // namespace interrupt
@@ -3,11 +3,15 @@
 
 #include <cstdint>
 
+#include "a/rt/keys.h"
+
 namespace interrupt {
 
 void set_target(unsigned k, unsigned target_key);
 void enable(unsigned k, bool clear_pending = false);
 
+rt::AutoKey destroy(unsigned k);
+
 }  // namespace interrupt
 
 #endif  // A_K_INTERRUPT_H
@@ -0,0 +1,40 @@
+#include "a/k/keyring.h"
+
+#include "etl/assert.h"
+#include "common/selectors.h"
+#include "a/rt/ipc.h"
+
+namespace S = selector::keyring;
+
+namespace keyring {
+
+void load(unsigned k, uint32_t index, uint32_t count, uint32_t keymap) {
+  Message msg {Descriptor::call(S::load, k), index, count};
+  rt::ipc2(msg, 0, keymap);
+  ETL_ASSERT(msg.desc.get_error() == false);
+}
+
+void store(unsigned k, uint32_t index, uint32_t count, uint32_t keymap) {
+  Message msg {Descriptor::call(S::store, k), index, count};
+  rt::ipc2(msg, keymap, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+}
+
+uint32_t get_size(unsigned k) {
+  Message msg {Descriptor::call(S::get_size, k)};
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return msg.d0;
+}
+
+rt::AutoKey destroy(unsigned k) {
+  Message msg {
+    Descriptor::call(S::destroy, k),
+  };
+  auto k_out = rt::AutoKey{};
+  rt::ipc2(msg, 0, rt::keymap(0, k_out, 0, 0));
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return k_out;
+}
+
+}  // namespace keyring
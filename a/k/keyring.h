@@ -0,0 +1,28 @@
+#ifndef A_K_KEYRING_H
+#define A_K_KEYRING_H
+
+#include <cstdint>
+
+#include "a/rt/keys.h"
+
+namespace keyring {
+
+/*
+ * Copies 'count' (1-3) keys, starting at 'index' in the Keyring, into the
+ * key registers given by 'keymap' (as with rt::keymap, position 0 unused).
+ */
+void load(unsigned k, uint32_t index, uint32_t count, uint32_t keymap);
+
+/*
+ * Copies 'count' (1-3) keys from the key registers given by 'keymap' into the
+ * Keyring, starting at 'index'.
+ */
+void store(unsigned k, uint32_t index, uint32_t count, uint32_t keymap);
+
+uint32_t get_size(unsigned k);
+
+rt::AutoKey destroy(unsigned k);
+
+}  // namespace keyring
+
+#endif  // A_K_KEYRING_H
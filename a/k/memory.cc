@@ -1,5 +1,6 @@
 #include "a/k/memory.h"
 
+#include "etl/algorithm.h"
 #include "etl/assert.h"
 
 #include "common/selectors.h"
@@ -16,6 +17,7 @@ Region inspect(unsigned k) {
   return {
     .rbar = msg.d0,
     .rasr = msg.d1,
+    .size = msg.d2,
   };
 }
 
@@ -33,6 +35,41 @@ rt::AutoKey split(unsigned k, uint32_t pos, unsigned slot_key) {
   return k_top;
 }
 
+void split_multiple(unsigned k, unsigned count, uint32_t const * sizes,
+                    unsigned const * slot_keys) {
+  ETL_ASSERT(count >= 2 && count <= 4);
+
+  // Unused positions are zero, which sends (and discards) null keys.
+  uint32_t s[3] {};
+  unsigned sk[3] {};
+  for (unsigned i = 0; i < count - 1; ++i) {
+    if (sizes) s[i] = sizes[i];
+    sk[i] = slot_keys[i];
+  }
+
+  Message msg {
+      Descriptor::call(S::split_multiple, k),
+      count,
+      s[0],
+      s[1],
+      s[2],
+  };
+  rt::ipc2(msg,
+      rt::keymap(0, sk[0], sk[1], sk[2]),
+      rt::keymap(k, sk[0], sk[1], sk[2]));
+  ETL_ASSERT(!msg.desc.get_error());
+}
+
+bool merge(unsigned k, unsigned upper_key) {
+  Message msg {
+      Descriptor::call(S::merge, k),
+  };
+  rt::ipc2(msg,
+      rt::keymap(0, upper_key, 0, 0),
+      rt::keymap(0, k, 0, 0));
+  return !msg.desc.get_error();
+}
+
 void become(unsigned k, ObjectType ot, unsigned arg, unsigned arg_key) {
   Message msg {
     Descriptor::call(S::become, k),
@@ -65,6 +102,54 @@ void poke(unsigned k, uint32_t offset, uint32_t word) {
   ETL_ASSERT(!msg.desc.get_error());
 }
 
+// Flag in d1 of peek_multiple and poke_multiple.
+static constexpr uint32_t fixed_bit = 1u << 8;
+
+void peek_multiple(unsigned k, uint32_t offset, uint32_t * out, size_t count,
+                   bool fixed) {
+  static constexpr size_t max_words = 5;
+
+  while (count) {
+    auto n = etl::min(count, max_words);
+    Message msg {
+      Descriptor::call(S::peek_multiple, k),
+      offset,
+      uint32_t(n) | (fixed ? fixed_bit : 0),
+    };
+    rt::ipc2(msg, 0, 0);
+    ETL_ASSERT(!msg.desc.get_error());
+
+    uint32_t const words[max_words] {msg.d0, msg.d1, msg.d2, msg.d3, msg.d4};
+    for (size_t i = 0; i < n; ++i) *out++ = words[i];
+
+    if (!fixed) offset += uint32_t(n);
+    count -= n;
+  }
+}
+
+void poke_multiple(unsigned k, uint32_t offset, uint32_t const * in,
+                   size_t count, bool fixed) {
+  static constexpr size_t max_words = 3;
+
+  while (count) {
+    auto n = etl::min(count, max_words);
+    Message msg {
+      Descriptor::call(S::poke_multiple, k),
+      offset,
+      uint32_t(n) | (fixed ? fixed_bit : 0),
+      in[0],
+      n > 1 ? in[1] : 0,
+      n > 2 ? in[2] : 0,
+    };
+    rt::ipc2(msg, 0, 0);
+    ETL_ASSERT(!msg.desc.get_error());
+
+    in += n;
+    if (!fixed) offset += uint32_t(n);
+    count -= n;
+  }
+}
+
 void make_child(unsigned k, uintptr_t base, size_t size, unsigned slot_key) {
   Message msg {
     Descriptor::call(S::make_child, k),
@@ -77,4 +162,38 @@ void make_child(unsigned k, uintptr_t base, size_t size, unsigned slot_key) {
   ETL_ASSERT(!msg.desc.get_error());
 }
 
+unsigned lock(unsigned k) {
+  Message msg {
+    Descriptor::call(S::lock, k),
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(!msg.desc.get_error());
+  return msg.d0;
+}
+
+unsigned unlock(unsigned k) {
+  Message msg {
+    Descriptor::call(S::unlock, k),
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(!msg.desc.get_error());
+  return msg.d0;
+}
+
+rt::AutoKey become_array(unsigned k, ObjectType ot, unsigned count,
+                         unsigned slot_key) {
+  Message msg {
+    Descriptor::call(S::become_array, k),
+    uint32_t(ot),
+    count,
+  };
+  auto k_first = rt::AutoKey{};
+  rt::ipc2(msg,
+      rt::keymap(0, slot_key, 0, 0),
+      rt::keymap(0, k_first, k, 0));
+  ETL_ASSERT(!msg.desc.get_error());
+
+  return k_first;
+}
+
 }  // namespace memory
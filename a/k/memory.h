@@ -11,13 +11,16 @@ namespace memory {
 struct Region {
   uint32_t rbar;
   uint32_t rasr;
+  // Size of the Memory in bytes.  For Memory mapped using subregions, this is
+  // smaller than the size implied by rasr.
+  uint32_t size;
 
   constexpr size_t get_l2_half_size() const {
     return (rasr >> 1) & 0x1F;
   }
 
   constexpr size_t get_size_words() const {
-    return 1u << (get_l2_half_size() - 1);
+    return size / sizeof(uint32_t);
   }
 
   constexpr uintptr_t get_base() const {
@@ -25,7 +28,7 @@ struct Region {
   }
 
   constexpr bool contains(uintptr_t addr) const {
-    return (addr - get_base() + 1) / 2 < (1u << get_l2_half_size());
+    return addr >= get_base() && addr - get_base() <= size;
   }
 };
 
@@ -33,10 +36,32 @@ Region inspect(unsigned k);
 
 rt::AutoKey split(unsigned k, uint32_t pos, unsigned slot_key);
 
+/*
+ * Splits the Memory in k into 'count' (2-4) pieces in one call.  'sizes' gives
+ * the sizes of the first count-1 pieces, the last taking the remainder; if
+ * 'sizes' is null, the pieces are equal.  slot_keys[i] holds a Slot to be
+ * donated for piece i+1.
+ *
+ * On return, k holds a key to the first piece, and slot_keys[i] a key to piece
+ * i+1.
+ */
+void split_multiple(unsigned k, unsigned count, uint32_t const * sizes,
+                    unsigned const * slot_keys);
+
+/*
+ * Merges the Memory in 'upper_key', which must begin where the Memory in k
+ * ends, into k.  The upper object's table entry is freed.  Returns false if
+ * the kernel refuses, e.g. because the objects differ in attributes; k is
+ * nulled in that case, but the objects are unchanged.
+ */
+bool merge(unsigned k, unsigned upper_key);
+
 enum class ObjectType : uint32_t {
   context = 0,
   gate = 1,
-  interrupt = 2,  // TODO synchronize with TypeCode in kernel
+  interrupt = 2,
+  timer = 3,
+  keyring = 4,  // TODO synchronize with TypeCode in kernel
 };
 
 void become(unsigned k, ObjectType, unsigned arg, unsigned arg_key = 0);
@@ -44,8 +69,36 @@ void become(unsigned k, ObjectType, unsigned arg, unsigned arg_key = 0);
 uint32_t peek(unsigned k, uint32_t offset);
 void poke(unsigned k, uint32_t offset, uint32_t data);
 
+/*
+ * Reads or writes 'count' words starting at 'offset', using as few calls as
+ * possible.  If 'fixed' is set, every word is transferred at 'offset', as for
+ * a device FIFO register.
+ */
+void peek_multiple(unsigned k, uint32_t offset, uint32_t * out, size_t count,
+                   bool fixed = false);
+void poke_multiple(unsigned k, uint32_t offset, uint32_t const * in,
+                   size_t count, bool fixed = false);
+
 void make_child(unsigned k, uintptr_t base, size_t size, unsigned slot_key);
 
+/*
+ * Pins the Memory in k against split, merge, become, and revocation, e.g.
+ * while a DMA transfer is using it.  Locks nest; each returns the new count.
+ * Both require a key with full access to the whole of the Memory.
+ */
+unsigned lock(unsigned k);
+unsigned unlock(unsigned k);
+
+/*
+ * Creates 'count' objects of one type from the front of the Memory in k, with
+ * heads in consecutive Slots starting with the one in 'slot_key', whose brand
+ * must cover at least count-1 following Slots.  Replaces k with a key to the
+ * remaining Memory (null if none remains), and returns a key to the first
+ * object.
+ */
+rt::AutoKey become_array(unsigned k, ObjectType, unsigned count,
+                         unsigned slot_key);
+
 }  // namespace memory
 
 #endif  // A_K_MEMORY_H
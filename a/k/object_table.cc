@@ -59,4 +59,62 @@ bool invalidate(unsigned k, unsigned index, bool rollover_ok) {
   return msg.desc.get_error() == false;
 }
 
+void mint_keys(unsigned k, uint32_t brand, uint32_t keymap,
+               unsigned i0, unsigned i1, unsigned i2, unsigned i3) {
+  Message msg {
+    Descriptor::call(S::mint_keys, k),
+    i0, i1, i2, i3,
+    brand,
+  };
+  rt::ipc2(msg, 0, keymap);
+  ETL_ASSERT(!msg.desc.get_error());
+}
+
+KindsInfo read_kinds(unsigned k, unsigned first_index) {
+  Message msg {
+    Descriptor::call(S::read_kinds, k),
+    first_index,
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(!msg.desc.get_error());
+
+  KindsInfo info;
+  for (unsigned i = 0; i < 8; ++i) {
+    info.kinds[i] = Kind((msg.d0 >> (4 * i)) & 0xF);
+  }
+  info.generations[0] = msg.d1;
+  info.generations[1] = msg.d2;
+  info.generations[2] = msg.d3;
+  info.generations[3] = msg.d4;
+  return info;
+}
+
+Maybe<uint32_t> alloc_slot(unsigned k, unsigned slot_key) {
+  Message msg {
+    Descriptor::call(S::alloc_slot, k),
+  };
+  rt::ipc2(msg, 0, rt::keymap(0, slot_key));
+  if (msg.desc.get_error()) return nothing;
+  return msg.d0;
+}
+
+bool free_slot(unsigned k, unsigned index) {
+  Message msg {
+    Descriptor::call(S::free_slot, k),
+    index,
+  };
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(!msg.desc.get_error());
+  return msg.d0 == 0;
+}
+
+uint32_t set_table_view(unsigned k, unsigned view_key) {
+  Message msg {
+    Descriptor::call(S::set_table_view, k),
+  };
+  rt::ipc2(msg, rt::keymap(0, view_key), 0);
+  ETL_ASSERT(!msg.desc.get_error());
+  return msg.d0;
+}
+
 }  // namespace object_table
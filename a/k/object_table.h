@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include "a/maybe.h"
 #include "a/rt/keys.h"
 
 namespace object_table {
@@ -22,6 +23,8 @@ enum class Kind : uint32_t {
   context,
   gate,
   interrupt,
+  timer,
+  keyring,
 };
 
 Kind get_kind(unsigned k, unsigned index);
@@ -30,6 +33,48 @@ rt::AutoKey mint_key(unsigned k, unsigned index, uint64_t brand);
 
 bool invalidate(unsigned k, unsigned index, bool rollover_ok = false);
 
+/*
+ * Mints keys to up to four objects in one operation, all with the same brand,
+ * delivering them into the key registers given by 'keymap' (as with
+ * rt::keymap, positions corresponding to i0-i3).  Index zero produces a null
+ * key.
+ *
+ * The brand is limited to 32 bits by the message format.  Keys with brands
+ * that use the high bits, such as sys's service keys, must be made one at a
+ * time with mint_key.
+ */
+void mint_keys(unsigned k, uint32_t brand, uint32_t keymap,
+               unsigned i0, unsigned i1 = 0, unsigned i2 = 0, unsigned i3 = 0);
+
+struct KindsInfo {
+  // Kinds of objects at the first index and seven following.
+  Kind kinds[8];
+  // Generations of objects at the first index and three following.
+  uint32_t generations[4];
+};
+
+KindsInfo read_kinds(unsigned k, unsigned first_index);
+
+/*
+ * Takes a Slot from the kernel's free list, delivering a key to it into
+ * 'slot_key'.  Returns its index, or nothing if no Slots are free.
+ */
+Maybe<uint32_t> alloc_slot(unsigned k, unsigned slot_key);
+
+/*
+ * Returns a Slot to the kernel's free list, revoking any keys to it.  Returns
+ * false if the kernel retired the Slot instead, because its generation is
+ * near wrapping around.
+ */
+bool free_slot(unsigned k, unsigned index);
+
+/*
+ * Asks the kernel to maintain a view of the Object Table (see
+ * common/table_view.h) in the Memory designated by 'view_key', replacing any
+ * previous view.  Returns the number of entries.  A null key removes the view.
+ */
+uint32_t set_table_view(unsigned k, unsigned view_key);
+
 }  // namespace object_table
 
 #endif  // A_K_OBJECT_TABLE_H
@@ -0,0 +1,46 @@
+#include "a/k/timer.h"
+
+#include "etl/assert.h"
+#include "common/selectors.h"
+#include "a/rt/ipc.h"
+
+namespace S = selector::timer;
+
+namespace timer {
+
+void set_target(unsigned k, unsigned target_key) {
+  Message msg {Descriptor::call(S::set_target, k)};
+  rt::ipc2(msg, rt::keymap(0, target_key, 0, 0), 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+}
+
+void arm(unsigned k, uint32_t delay_ticks) {
+  Message msg {Descriptor::call(S::arm, k), delay_ticks};
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+}
+
+void disarm(unsigned k) {
+  Message msg {Descriptor::call(S::disarm, k)};
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+}
+
+uint32_t read_clock(unsigned k) {
+  Message msg {Descriptor::call(S::read_clock, k)};
+  rt::ipc2(msg, 0, 0);
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return msg.d0;
+}
+
+rt::AutoKey destroy(unsigned k) {
+  Message msg {
+    Descriptor::call(S::destroy, k),
+  };
+  auto k_out = rt::AutoKey{};
+  rt::ipc2(msg, 0, rt::keymap(0, k_out, 0, 0));
+  ETL_ASSERT(msg.desc.get_error() == false);
+  return k_out;
+}
+
+}  // namespace timer
@@ -0,0 +1,19 @@
+#ifndef A_K_TIMER_H
+#define A_K_TIMER_H
+
+#include <cstdint>
+
+#include "a/rt/keys.h"
+
+namespace timer {
+
+void set_target(unsigned k, unsigned target_key);
+void arm(unsigned k, uint32_t delay_ticks);
+void disarm(unsigned k);
+uint32_t read_clock(unsigned k);
+
+rt::AutoKey destroy(unsigned k);
+
+}  // namespace timer
+
+#endif  // A_K_TIMER_H
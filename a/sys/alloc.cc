@@ -1,45 +1,42 @@
 #include "a/sys/alloc.h"
 
+#include "etl/algorithm.h"
 #include "etl/array_count.h"
+#include "etl/assert.h"
+#include "etl/utility.h"
+#include "etl/armv7m/mpu.h"
 
 #include "a/sys/keys.h"
 #include "a/sys/types.h"
+#include "a/k/context.h"
 #include "a/k/object_table.h"
 #include "a/k/memory.h"
 #include "a/rt/ipc.h"
 #include "a/rt/keys.h"
 
 #include "common/message.h"
+#include "common/table_view.h"
 
 #include "peanut_config.h"
 
+using etl::armv7m::Mpu;
+using Rasr = Mpu::rasr_value_t;
+
 namespace sys {
 
 static constexpr auto allocation_failed = Exception(0x1c8af06d150e8638);
 
 
 /*******************************************************************************
- * Slot allocator.  Serves up slots designated as "extra" in the AppInfo block.
- * Slots, once served, cannot be returned to the pool.
+ * Slot allocator.  The kernel keeps the slots designated as "extra" in the
+ * AppInfo block on a free list; we just draw from it.
  */
 
-// Number of slots we do not manage.
-static constexpr unsigned fixed_slot_count =
-  4 + config::memory_map_count + config::device_map_count;
-
-// Number of slots we have handed out.
-static unsigned slots_used = 0;
-
-// Internal implementation of slot allocation.
-static Maybe<TableIndex> alloc_slot_int() {
-  if (slots_used == config::extra_slot_count) return nothing;
-  return slots_used++ + fixed_slot_count;
-}
-
-// External version.
 rt::AutoKey alloc_slot() {
-  auto oti = alloc_slot_int().ref();
-  return object_table::mint_key(ki::ot, oti, 0);
+  auto k = rt::AutoKey{};
+  auto maybe_index = object_table::alloc_slot(ki::ot, k);
+  ETL_ASSERT(maybe_index);
+  return k;
 }
 
 
@@ -47,59 +44,260 @@ rt::AutoKey alloc_slot() {
  * Memory allocator.
  */
 
-// We maintain a linked list for every power-of-two block size.  For
+// We maintain a list of free blocks for every power-of-two block size.  For
 // simplicity, we track all sizes, even the small ones we don't allow, and the
-// big ones that we're unlikely to ever use.
-//
-// The number in mem_roots[x] is the Object Table index of the first free
-// Memory object of size 2^(x+1).  That is, the mem_roots table is keyed by
+// big ones that we're unlikely to ever use.  mem_roots[x] holds the first free
+// block of size 2^(x+1); that is, the mem_roots table is keyed by
 // l2_half_size.
 //
-// The Object Table index of the *next* free object of size 2^(x+1) is stored
-// in the first word of the Memory object.  Thus a linked list is formed.
+// The lists are made of records kept here, rather than threaded through the
+// blocks themselves, so that we can find a freed block's buddy -- and learn
+// whether it's free -- without any IPC.
 //
-// Zero is the Object Table index of Null, so we use it as an end-of-list
-// marker (or, in mem_roots[x], an empty-list indicator).
-static TableIndex mem_roots[31];
-
-static rt::AutoKey mem_take(unsigned l2_half_size, uint64_t brand) {
-  auto oti = mem_roots[l2_half_size];
-  auto k = object_table::mint_key(ki::ot, oti, brand);
-  mem_roots[l2_half_size] = memory::peek(k, 0);
-  memory::poke(k, 0, 0);
-  return k;
+// Every free block is a Memory object in its own Object Table entry, so there
+// can't be more of them than the table has entries for Memory.
+static constexpr unsigned max_free_blocks =
+  config::memory_map_count + config::memory_run_block_count
+  + config::extra_slot_count;
+
+struct FreeBlock {
+  uintptr_t base;
+  uint32_t size;
+  TableIndex oti;
+  FreeBlock * next;
+};
+
+static FreeBlock * mem_roots[31];
+
+// Free Memory that isn't a naturally aligned power of two -- returned object
+// bodies, and pieces we couldn't afford the Slots to cut up -- is kept on a
+// separate list, in the same records, until its neighbours come back and it
+// can be merged into something the power-of-two lists can use.
+static FreeBlock * scraps;
+
+static FreeBlock free_block_records[max_free_blocks];
+// Records never yet used start at this index; records that have been used and
+// released are kept on the spare list.
+static unsigned free_block_records_used;
+static FreeBlock * spare_free_blocks;
+
+static void push_record(FreeBlock ** list, uintptr_t base, uint32_t size,
+                        TableIndex oti) {
+  FreeBlock * block;
+  if (spare_free_blocks) {
+    block = spare_free_blocks;
+    spare_free_blocks = block->next;
+  } else {
+    ETL_ASSERT(free_block_records_used < max_free_blocks);
+    block = &free_block_records[free_block_records_used++];
+  }
+
+  *block = { base, size, oti, *list };
+  *list = block;
+}
+
+static void mem_push(unsigned l2_half_size, uintptr_t base, TableIndex oti) {
+  push_record(&mem_roots[l2_half_size], base, 2u << l2_half_size, oti);
+}
+
+// Unlinks a record from a freelist, given a pointer to the link that refers
+// to it.  Returns the record's contents.
+static FreeBlock mem_unlink(FreeBlock ** link) {
+  auto block = *link;
+  auto contents = *block;
+  *link = block->next;
+  block->next = spare_free_blocks;
+  spare_free_blocks = block;
+  return contents;
+}
+
+// The Object Table view, once map_table_view has set it up.
+static TableViewEntry const * table_view;
+
+// Removes the block with the given base from a freelist, if it's there.
+// Returns its table index, or zero if it's not free.
+static TableIndex mem_remove(unsigned l2_half_size, uintptr_t base) {
+  for (auto link = &mem_roots[l2_half_size]; *link; link = &(*link)->next) {
+    if ((*link)->base == base) return mem_unlink(link).oti;
+  }
+  return 0;
+}
+
+void seed_mem(unsigned l2_half_size, uintptr_t base, TableIndex oti) {
+  mem_push(l2_half_size, base, oti);
+}
+
+// Checks whether Memory can go straight onto the power-of-two freelists.
+static bool is_block(uintptr_t base, uint32_t size) {
+  return size >= 32 && !(size & (size - 1)) && !(base & (size - 1));
+}
+
+// Adds a naturally aligned power-of-two block, whose key is in 'k', to the
+// freelists, merging it with its buddy (and the result with its buddy, and so
+// on) whenever the buddy is also free.  Consumes the key.
+static void free_block(KeyIndex k, TableIndex oti, uintptr_t base,
+                       unsigned l2_half_size) {
+  // Coalesce with free buddies.  Merging hands the upper block's table entry
+  // back to the kernel's free Slot list.
+  while (l2_half_size + 1 < etl::array_count(mem_roots)) {
+    auto buddy_base = base ^ (2u << l2_half_size);
+    auto buddy_oti = mem_remove(l2_half_size, buddy_base);
+    if (!buddy_oti) break;
+
+    auto k_buddy = object_table::mint_key(ki::ot, buddy_oti, 0);
+    bool merged = buddy_base < base
+      ? memory::merge(k_buddy, k)
+      : memory::merge(k, k_buddy);
+    if (!merged) {
+      // The kernel wouldn't do it (e.g. the blocks differ in attributes), so
+      // leave the buddy where it was.
+      mem_push(l2_half_size, buddy_base, buddy_oti);
+      break;
+    }
+
+    if (buddy_base < base) {
+      // The buddy's entry now holds the merged block.
+      rt::copy_key(k, k_buddy);
+      oti = buddy_oti;
+      base = buddy_base;
+    }
+    ++l2_half_size;
+  }
+
+  mem_push(l2_half_size, base, oti);
+
+  // Deny access to that key we just made.
+  rt::copy_key(k, ki::null);
 }
 
-// Adds a Memory object to the freelist.  This is used during initialization,
-// and could eventually be used to free Memory, once we allow that.
+// Object Table index, base, and size in bytes of the uncarved part of the
+// current body block (see alloc_body_mem).  An index of zero means no block.
+static TableIndex carve_oti;
+static uintptr_t carve_base;
+static size_t carve_left;
+
+// Returns free Memory of any shape, whose key is in 'k', to the allocator.
+// Consumes the key.
+static void free_scrap(KeyIndex k, TableIndex oti, uintptr_t base,
+                       uint32_t size) {
+  // A body returned from just below the uncarved part of the current body
+  // block rejoins it, so that carving can reuse the space.
+  if (carve_oti && base + size == carve_base) {
+    auto k_carve = object_table::mint_key(ki::ot, carve_oti, 0);
+    if (memory::merge(k, k_carve)) {
+      carve_oti = oti;
+      carve_base = base;
+      carve_left += size;
+      rt::copy_key(k, ki::null);
+      return;
+    }
+    rt::copy_key(k, object_table::mint_key(ki::ot, oti, 0));
+  }
+
+  // Merge with free neighbours on either side, until there are none.  Scraps
+  // on the list have already been merged with each other, so there is at most
+  // one on each side.
+  for (bool grew = true; grew; ) {
+    grew = false;
+    for (auto link = &scraps; *link; link = &(*link)->next) {
+      auto & n = **link;
+      bool below = n.base + n.size == base;
+      if (!below && base + size != n.base) continue;
+
+      auto neighbour = mem_unlink(link);
+      auto k_n = object_table::mint_key(ki::ot, neighbour.oti, 0);
+      bool merged = below ? memory::merge(k_n, k) : memory::merge(k, k_n);
+      if (!merged) {
+        // Leave the neighbour be; merge nulls the lower key on failure.
+        push_record(&scraps, neighbour.base, neighbour.size, neighbour.oti);
+        if (!below) rt::copy_key(k, object_table::mint_key(ki::ot, oti, 0));
+        break;
+      }
+
+      if (below) {
+        rt::copy_key(k, k_n);
+        oti = neighbour.oti;
+        base = neighbour.base;
+      }
+      size += neighbour.size;
+      grew = true;
+      break;
+    }
+  }
+
+  // Cut what we can into naturally aligned power-of-two blocks, each as large
+  // as the alignment of its base allows.  This needs a Slot per cut; if we run
+  // out, the rest waits on the scrap list.
+  while (!is_block(base, size) && !(base & 31) && !(size & 31)) {
+    auto align = base ? uint32_t(base & -base) : 0x80000000u;
+    auto piece = etl::min(align, 1u << (31 - __builtin_clz(size)));
+
+    auto k_slot = rt::AutoKey{};
+    auto maybe_rest_oti = object_table::alloc_slot(ki::ot, k_slot);
+    if (!maybe_rest_oti) break;
+
+    auto k_rest = memory::split(k, piece, k_slot);
+    free_block(k, oti, base, unsigned(__builtin_ctz(piece)) - 1);
+
+    rt::copy_key(k, k_rest);
+    oti = maybe_rest_oti.ref();
+    base += piece;
+    size -= piece;
+  }
+
+  if (is_block(base, size)) {
+    free_block(k, oti, base, unsigned(__builtin_ctz(size)) - 1);
+  } else {
+    push_record(&scraps, base, size, oti);
+    rt::copy_key(k, ki::null);
+  }
+}
+
+// Returns Memory to the allocator.  Power-of-two blocks go onto the
+// freelists, coalescing with their buddies; Memory of other shapes, such as
+// object bodies and trimmed program RAM, is merged with its free neighbours
+// and cut back into blocks.  This is used during initialization, and to
+// return Memory.
 //
 // Returns a flag indicating success; failure means the key was not Memory, or
-// that its generation has advanced far enough to require intervention.
+// that the Memory can't be revoked (e.g. it's locked, or its generation has
+// advanced far enough to require intervention).  On failure, the caller's key
+// remains valid.
 bool free_mem(KeyIndex key_in) {
   // Crack open the key to find its Object Table index.
   auto key_info = object_table::read_key(ki::ot, key_in);
   auto oti = key_info.index;
 
   // Defend against weird clients by checking the kind.
-  if (object_table::get_kind(ki::ot, oti) != object_table::Kind::memory) {
-    return false;
+  auto kind = table_view ? object_table::Kind(table_view[oti].kind)
+                         : object_table::get_kind(ki::ot, oti);
+  if (kind != object_table::Kind::memory) return false;
+
+  // Learn the extent while the caller's key still works.  Invalidation won't
+  // change it.
+  uintptr_t base;
+  uint32_t size;
+  if (table_view) {
+    base = table_view[oti].base;
+    size = table_view[oti].size;
+  } else {
+    auto region = memory::inspect(key_in);
+    base = region.get_base();
+    size = region.size;
   }
+  if (size == 0) return false;
 
   // Revoke outside access to this object.  Ours now.
   if (object_table::invalidate(ki::ot, oti) == false) return false;
 
   // Now, produce a fresh key.
   auto k_freed = object_table::mint_key(ki::ot, oti, 0);
-  // Determine its properties.
-  auto region = memory::inspect(k_freed);
-  auto l2_half_size = region.get_l2_half_size();
-  // Add it to the list.
-  memory::poke(k_freed, 0, mem_roots[l2_half_size]);
-  mem_roots[l2_half_size] = oti;
-
-  // Deny access to that key we just made.
-  rt::copy_key(k_freed, ki::null);
 
+  if (is_block(base, size)) {
+    free_block(k_freed, oti, base, unsigned(__builtin_ctz(size)) - 1);
+  } else {
+    free_scrap(k_freed, oti, base, size);
+  }
   return true;
 }
 
@@ -117,55 +315,219 @@ Maybe<rt::AutoKey> alloc_mem(unsigned target_l2_half_size, uint64_t brand) {
 
   static constexpr uint64_t internal_mem_brand = 0;  // TODO empower
 
+  // A single split_multiple can produce this many pieces, and so can descend
+  // this many levels, less one.
+  static constexpr unsigned max_pieces = 4;
+
   if (target_l2_half_size < 4) return nothing;  // Not satisfiable.
 
-  // Massage the freelists so we have a memory block of the desired size, or
-  // return false.
-  {
-    unsigned l2p;
-    // Pass one: search up through the freelists to find a non-empty one.
-    // Note that, if a block of the target size already exists, this leaves
-    // l2p == target_l2_half_size.
-    for (l2p = target_l2_half_size; l2p < etl::array_count(mem_roots); ++l2p) {
-      if (mem_roots[l2p]) break;
+  // Search up through the freelists to find a non-empty one.  Note that, if a
+  // block of the target size already exists, this leaves
+  // l2p == target_l2_half_size.
+  unsigned l2p;
+  for (l2p = target_l2_half_size; l2p < etl::array_count(mem_roots); ++l2p) {
+    if (mem_roots[l2p]) break;
+  }
+
+  // If we just ran off the top end of mem_roots, it means we're out of RAM.
+  // (This is also where we catch large size parameters.)
+  if (l2p >= etl::array_count(mem_roots)) return nothing;
+
+  auto block = mem_unlink(&mem_roots[l2p]);
+
+  if (l2p == target_l2_half_size) {
+    return object_table::mint_key(ki::ot, block.oti, brand);
+  }
+
+  // We'll keep the block's key in hand as we split our way down, rather than
+  // putting the bottom pieces back on freelists.
+  auto k_block = object_table::mint_key(ki::ot, block.oti, internal_mem_brand);
+
+  while (l2p > target_l2_half_size) {
+    // Descend up to three levels at once: a block of size 8s splits into
+    // pieces of s (which we keep), s, 2s, and 4s.  The pieces remain naturally
+    // aligned.
+    auto levels = etl::min(l2p - target_l2_half_size, max_pieces - 1);
+
+    // Allocate slots for the pieces we'll give away.
+    rt::AutoKey k_slots[max_pieces - 1];
+    TableIndex slot_otis[max_pieces - 1];
+    unsigned slot_keys[max_pieces - 1];
+    for (unsigned i = 0; i < levels; ++i) {
+      auto maybe_oti = object_table::alloc_slot(ki::ot, k_slots[i]);
+      if (!maybe_oti) {
+        if (i == 0) {
+          // Out of slots!  Put the block back where we found it.
+          mem_push(l2p, block.base, block.oti);
+          return nothing;
+        }
+        // Make do with fewer levels this time around.
+        levels = i;
+        break;
+      }
+      slot_otis[i] = maybe_oti.ref();
+      slot_keys[i] = k_slots[i];
     }
 
-    // If we just ran off the top end of mem_roots, it means we're out of RAM.
-    // (This is also where we catch large size parameters.)
-    if (l2p >= etl::array_count(mem_roots)) return nothing;
+    auto bottom_l2 = l2p - levels;
+    uint32_t sizes[max_pieces - 1];
+    sizes[0] = 2u << bottom_l2;
+    for (unsigned i = 1; i < levels; ++i) sizes[i] = 2u << (bottom_l2 + i - 1);
+
+    memory::split_multiple(k_block, levels + 1, sizes, slot_keys);
+
+    // Piece i+1 is one level larger than piece i, and starts where the pieces
+    // below it, which sum to its size, end.  Put them on their freelists.
+    for (unsigned i = 0; i < levels; ++i) {
+      auto l2 = bottom_l2 + i;
+      mem_push(l2, block.base + (2u << l2), slot_otis[i]);
+    }
+
+    l2p = bottom_l2;
+  }
+
+  // Reissue the key with the caller's brand.
+  return object_table::mint_key(ki::ot, block.oti, brand);
+}
+
+void trim_mem(KeyIndex k, size_t size) {
+  static constexpr unsigned max_pieces = 4;
+
+  auto region = memory::inspect(k);
+  auto full = region.size;
+  if (size >= full) return;
+
+  // The tail is cut into naturally aligned power-of-two pieces: each starts
+  // where the last ended, and is as large as that offset's alignment allows.
+  uint32_t sizes[max_pieces - 1];
+  sizes[0] = uint32_t(size);
+  unsigned count = 1;
+  for (uint32_t offset = uint32_t(size); offset < full; ++count) {
+    // Only the kept piece and the first two of the tail pieces are given
+    // sizes; the last piece takes the remainder.
+    if (count == max_pieces) return;  // Too ragged to trim.
+    auto piece = offset & -offset;
+    if (count < max_pieces - 1) sizes[count] = piece;
+    offset += piece;
+  }
+
+  rt::AutoKey k_slots[max_pieces - 1];
+  TableIndex slot_otis[max_pieces - 1];
+  unsigned slot_keys[max_pieces - 1];
+  for (unsigned i = 0; i < count - 1; ++i) {
+    auto maybe_oti = object_table::alloc_slot(ki::ot, k_slots[i]);
+    if (!maybe_oti) {
+      // Out of slots: leave the block untrimmed, which is wasteful but safe.
+      for (unsigned j = 0; j < i; ++j) {
+        object_table::free_slot(ki::ot, slot_otis[j]);
+      }
+      return;
+    }
+    slot_otis[i] = maybe_oti.ref();
+    slot_keys[i] = k_slots[i];
+  }
+
+  memory::split_multiple(k, count, sizes, slot_keys);
+
+  // The pieces' buddies lie within the kept piece, so there's no coalescing
+  // to do until it's freed.
+  auto offset = uint32_t(size);
+  for (unsigned i = 0; i < count - 1; ++i) {
+    auto piece = offset & -offset;
+    mem_push(__builtin_ctz(piece) - 1, region.get_base() + offset,
+        slot_otis[i]);
+    offset += piece;
+  }
+}
+
+
+bool map_table_view(size_t count, unsigned region) {
+  // The view is read-only to us; the kernel writes it.
+  static constexpr uint64_t view_brand = uint32_t(Rasr()
+      .with_ap(Mpu::AccessPermissions::p_read_u_read)
+      .with_xn(true)) >> 8;
+
+  unsigned l2_half_size = 4;
+  while ((2u << l2_half_size) < count * sizeof(TableViewEntry)) {
+    ++l2_half_size;
+  }
 
-    // Pass two: work back down through freelists, splitting at each step, until
-    // we return to our target freelist.
-    for (; l2p > target_l2_half_size; --l2p) {
-      // Get a key to the head of this freelist and remove it.
-      auto k_bot = mem_take(l2p, internal_mem_brand);
-      auto k_bot_info = object_table::read_key(ki::ot, k_bot);
+  auto maybe_view = alloc_mem(l2_half_size, view_brand);
+  if (!maybe_view) return false;
+  auto & k_view = maybe_view.ref();
 
-      // Allocate a slot for the new top-half object.
-      auto maybe_top_oti = alloc_slot_int();
-      if (!maybe_top_oti) return nothing;  // Out of slots!
+  object_table::set_table_view(ki::ot, k_view);
+  context::set_region(ki::self, region, k_view);
+
+  table_view = reinterpret_cast<TableViewEntry const *>(
+      memory::inspect(k_view).get_base());
+  return true;
+}
 
-      auto top_oti = maybe_top_oti.ref();
 
-      // Mint a slot key.
-      auto k_slot = object_table::mint_key(ki::ot, top_oti, 0);
+/*******************************************************************************
+ * Object body allocator.  Kernel object bodies are never mapped, so rather
+ * than rounding them up to a power of two, we carve them to size from the
+ * front of a larger block.
+ */
 
-      // Perform the split.  This technically has us using one more slot key
-      // than we need to, but not for long.
-      auto k_top = memory::split(k_bot, 1u << l2p, k_slot);
+// Blocks are taken from the Memory allocator at this size (2^(x+1)).
+static constexpr unsigned carve_l2_half_size = 10;
 
-      // Return both halves to the freelist for the next-smaller size.
-      memory::poke(k_top, 0, mem_roots[l2p - 1]);
-      memory::poke(k_bot, 0, top_oti);
-      mem_roots[l2p - 1] = k_bot_info.index;
+// The kernel requires bodies to be aligned to this many bytes.
+static constexpr size_t body_alignment = 8;
 
-      // Proceed to next freelist.
+Maybe<rt::AutoKey> alloc_body_mem(size_t size) {
+  static constexpr uint64_t internal_mem_brand = 0;  // TODO empower
+
+  // Keep the next body aligned.
+  size = (size + body_alignment - 1) & ~(body_alignment - 1);
+
+  // Bodies that would use up most of a block gain little from carving.
+  if (size > (1u << carve_l2_half_size)) {
+    unsigned l2_half_size = 4;
+    while ((2u << l2_half_size) < size) ++l2_half_size;
+    return alloc_mem(l2_half_size, internal_mem_brand);
+  }
+
+  if (carve_left < size) {
+    // Start a new block.  Any remainder of the old one is too small to be
+    // useful here, so it waits on the scrap list for its neighbours.
+    auto maybe_block = alloc_mem(carve_l2_half_size, internal_mem_brand);
+    if (!maybe_block) return nothing;
+
+    if (carve_oti) {
+      auto k_old = object_table::mint_key(ki::ot, carve_oti, 0);
+      free_scrap(k_old, carve_oti, carve_base, uint32_t(carve_left));
     }
+
+    auto & k_block = maybe_block.ref();
+    carve_oti = object_table::read_key(ki::ot, k_block).index;
+    carve_base = memory::inspect(k_block).get_base();
+    carve_left = 2u << carve_l2_half_size;
   }
 
-  // The code above has ensured that there is at least one memory object free
-  // in mem_roots[target_l2_half_size], so now we just take it.
-  return mem_take(target_l2_half_size, brand);
+  auto k_body = object_table::mint_key(ki::ot, carve_oti, internal_mem_brand);
+
+  if (carve_left == size) {
+    // Take the whole thing.
+    carve_oti = 0;
+    carve_base = 0;
+    carve_left = 0;
+    return etl::move(k_body);
+  }
+
+  auto k_slot = rt::AutoKey{};
+  auto maybe_rest_oti = object_table::alloc_slot(ki::ot, k_slot);
+  if (!maybe_rest_oti) return nothing;  // Out of slots!
+
+  // Split the body off the front.  The remainder moves into the new slot.
+  memory::split(k_body, uint32_t(size), k_slot);
+  carve_oti = maybe_rest_oti.ref();
+  carve_base += size;
+  carve_left -= size;
+
+  return etl::move(k_body);
 }
 
 }  // namespace sys
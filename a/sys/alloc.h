@@ -1,6 +1,8 @@
 #ifndef A_SYS_ALLOC_H
 #define A_SYS_ALLOC_H
 
+#include <cstddef>
+
 #include "a/sys/types.h"
 #include "a/maybe.h"
 #include "a/rt/keys.h"
@@ -9,9 +11,47 @@ namespace sys {
 
 rt::AutoKey alloc_slot();
 
+/*
+ * Returns the Memory in the given key to the allocator, revoking all other
+ * keys to it.  Any Memory the allocator handed out can be returned this way,
+ * including trimmed RAM and object bodies.  Returns false, leaving the Memory
+ * and the key untouched, if the key isn't to Memory or the Memory can't be
+ * revoked.
+ */
 bool free_mem(KeyIndex);
+
+/*
+ * Adds a Memory block made by the kernel at boot (see AppInfo::memory_runs)
+ * to the freelists, without asking the kernel about it.  The caller vouches
+ * that the block at table index 'oti' is free, naturally aligned Memory of
+ * 2^(l2_half_size+1) bytes at 'base'.  Unlike free_mem, this doesn't
+ * coalesce buddies.
+ */
+void seed_mem(unsigned l2_half_size, uintptr_t base, TableIndex oti);
 Maybe<rt::AutoKey> alloc_mem(unsigned l2_half_size, uint64_t brand);
 
+/*
+ * Trims the power-of-two Memory in k down to 'size' bytes, returning the rest
+ * to the allocator.  'size' should be a multiple of an eighth of the original,
+ * so that the result can still be mapped using subregions.  If the Memory
+ * can't be trimmed (e.g. for lack of Slots), it's left as it was.
+ */
+void trim_mem(KeyIndex k, size_t size);
+
+/*
+ * Allocates Memory to be donated to the kernel for an object body of the
+ * given size.  The result is cut to size and is generally not mappable.
+ */
+Maybe<rt::AutoKey> alloc_body_mem(size_t size);
+
+/*
+ * Allocates Memory for a view of the Object Table's 'count' entries, asks the
+ * kernel to maintain it, and maps it read-only into region register 'region'
+ * of our own Context.  Once this succeeds, the allocator learns about objects
+ * it owns by reading the view, rather than asking the kernel.
+ */
+bool map_table_view(size_t count, unsigned region);
+
 }  // namespace sys
 
 #endif  // A_SYS_ALLOC_H
@@ -0,0 +1,182 @@
+#ifndef A_SYS_LAYOUT_H
+#define A_SYS_LAYOUT_H
+
+/*
+ * Compile-time layout of the system.
+ *
+ * The application describes its system declaratively in peanut_config.h: how
+ * many memory map windows it has, how its RAM should be split, and which
+ * objects the kernel should make at boot.  The types here derive everything
+ * else from that description -- the AppInfo memory runs, the index of every
+ * object in the Object Table, and the amount of RAM to donate to the kernel
+ * -- so that none of it needs to be counted by hand.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/abi_sizes.h"
+#include "common/app_info.h"
+
+#include "a/k/memory.h"
+
+namespace sys {
+namespace layout {
+
+constexpr unsigned popcount(uint32_t x) {
+  return x ? (x & 1) + popcount(x >> 1) : 0;
+}
+
+constexpr uint32_t high_bit(uint32_t x) {
+  return 1u << kabi::log2floor(x);
+}
+
+// Number of memory runs an AppInfo block can hold.
+static constexpr unsigned max_runs =
+  sizeof(AppInfo::memory_runs) / sizeof(AppInfo::MemoryRun);
+
+/*
+ * Application RAM, to be created by the kernel as memory runs (see
+ * AppInfo::memory_runs) and fed to the allocator without splitting.
+ *
+ * 'small_count' blocks of 2^(small_l2_half_size+1) bytes are set aside at the
+ * top, for object bodies and small programs.  The rest is cut into the fewest
+ * power-of-two blocks, largest first, which leaves every block naturally
+ * aligned provided the RAM itself is aligned to its largest block.
+ */
+struct RamRuns {
+  uint32_t size;
+  unsigned small_l2_half_size;
+  unsigned small_count;
+
+  constexpr uint32_t small_size() const {
+    return 2u << small_l2_half_size;
+  }
+
+  // Bytes left for the large blocks.  Each set bit is one block.
+  constexpr uint32_t large_part() const {
+    return size - small_size() * small_count;
+  }
+
+  constexpr unsigned run_count() const {
+    return popcount(large_part()) + (small_count ? 1 : 0);
+  }
+
+  constexpr unsigned block_count() const {
+    return popcount(large_part()) + small_count;
+  }
+
+  constexpr bool is_valid() const {
+    return small_l2_half_size >= 4
+        && size % small_size() == 0
+        && small_size() * small_count <= size
+        && run_count() <= max_runs;
+  }
+
+  /*
+   * Produces run 'i' for RAM starting at 'base', or an empty run if there is
+   * no such run.
+   */
+  constexpr AppInfo::MemoryRun run(uint32_t base, unsigned i) const {
+    return i < popcount(large_part()) ? large_run(base, large_part(), i)
+         : i < run_count() ? AppInfo::MemoryRun {
+             base + large_part(), small_l2_half_size, small_count }
+         : AppInfo::MemoryRun { 0, 0, 0 };
+  }
+
+private:
+  // The i'th large block is the i'th highest set bit of 'rest'; it starts
+  // where the larger blocks, i.e. the higher bits, end.
+  static constexpr AppInfo::MemoryRun large_run(uint32_t base,
+                                                uint32_t rest,
+                                                unsigned i) {
+    return i ? large_run(base + high_bit(rest), rest - high_bit(rest), i - 1)
+             : AppInfo::MemoryRun {
+                 base, kabi::log2floor(high_bit(rest)) - 1, 1 };
+  }
+};
+
+/*
+ * Body size donated to the kernel for an object it creates at boot.
+ */
+constexpr size_t boot_body_size(memory::ObjectType t) {
+  return t == memory::ObjectType::context ? kabi::context_size
+       : t == memory::ObjectType::gate ? kabi::gate_size
+       : 0;
+}
+
+template <size_t N>
+constexpr size_t boot_body_total(memory::ObjectType const (&types)[N],
+                                 size_t i = 0) {
+  return i < N ? boot_body_size(types[i]) + boot_body_total(types, i + 1)
+               : 0;
+}
+
+template <size_t N>
+constexpr bool boot_types_valid(memory::ObjectType const (&types)[N],
+                                size_t i = 0) {
+  return i < N ? boot_body_size(types[i]) && boot_types_valid(types, i + 1)
+               : N <= sizeof(AppInfo::boot_object_types) / sizeof(uint32_t);
+}
+
+/*
+ * Type code for boot object 'i', for filling in AppInfo::boot_object_types.
+ * Unused positions read as zero.
+ */
+template <size_t N>
+constexpr uint32_t boot_type(memory::ObjectType const (&types)[N], size_t i) {
+  return i < N ? uint32_t(types[i]) : 0;
+}
+
+/*
+ * Object Table layout, in the order the kernel creates objects at boot (see
+ * k/app.cc).
+ */
+struct TableLayout {
+  unsigned memory_map_count;
+  unsigned device_map_count;
+  unsigned run_block_count;
+  unsigned boot_object_count;
+  unsigned extra_slot_count;
+
+  constexpr unsigned first_memory() const {
+    return kabi::well_known_object_count;
+  }
+
+  constexpr unsigned first_device() const {
+    return first_memory() + memory_map_count;
+  }
+
+  constexpr unsigned first_run_block() const {
+    return first_device() + device_map_count;
+  }
+
+  constexpr unsigned first_boot_object() const {
+    return first_run_block() + run_block_count;
+  }
+
+  constexpr unsigned first_extra_slot() const {
+    return first_boot_object() + boot_object_count;
+  }
+
+  constexpr unsigned size() const {
+    return first_extra_slot() + extra_slot_count;
+  }
+
+  /*
+   * RAM the kernel needs donated: the first Context's body, the Object Table,
+   * the interrupt redirection table, and boot object bodies.
+   */
+  constexpr size_t donation_size(unsigned external_interrupt_count,
+                                 size_t boot_bodies) const {
+    return kabi::context_size
+         + kabi::object_head_size * size()
+         + sizeof(void *) * (1 + external_interrupt_count)
+         + boot_bodies;
+  }
+};
+
+}  // namespace layout
+}  // namespace sys
+
+#endif  // A_SYS_LAYOUT_H
@@ -7,6 +7,7 @@
 #include <cstdint>
 
 #include "etl/algorithm.h"
+#include "etl/array_count.h"
 #include "etl/armv7m/mpu.h"
 #include "etl/armv7m/exception_frame.h"
 
@@ -17,8 +18,12 @@
 #include "a/sys/keys.h"
 #include "a/k/memory.h"
 #include "a/k/context.h"
+#include "a/k/gate.h"
+#include "a/k/object_table.h"
 #include "a/rt/keys.h"
 
+#include "peanut_config.h"
+
 using etl::min;
 using etl::armv7m::Mpu;
 using Rasr = Mpu::rasr_value_t;
@@ -98,10 +103,17 @@ static bool is_valid(Header const & hdr) {
 
 /*
  * Determines the size of Memory object required for the RAM segment
- * (data + BSS + stack) of a program, given its header.
+ * (data + BSS + stack) of a program, given its header.  Small segments are
+ * rounded up to a power of two; larger ones need only be rounded to an eighth
+ * of one, since they can be mapped using subregions.
  */
 static unsigned get_ram_size(Header const & hdr) {
-  return round_up_p2(hdr.bss_end - hdr.text_end + hdr.stack_size);
+  auto need = hdr.bss_end - hdr.text_end + hdr.stack_size;
+  auto p2 = round_up_p2(need);
+  if (p2 < 256) return p2;
+
+  auto eighth = p2 / 8;
+  return (need + eighth - 1) & ~(eighth - 1);
 }
 
 
@@ -132,6 +144,96 @@ static uintptr_t relocate_got_entry(Header const & hdr,
 }
 
 
+/*
+ * Reads the header of the image at word offset 'img_offset' within the Memory
+ * in 'img_key'.  The caller must have checked that the image lies within the
+ * Memory.
+ */
+static Header read_header(KeyIndex img_key, uint32_t img_offset) {
+  return {
+    .image_size = memory::peek(img_key, img_offset),
+    .text_end   = memory::peek(img_key, img_offset + 1),
+    .got_end    = memory::peek(img_key, img_offset + 2),
+    .bss_end    = memory::peek(img_key, img_offset + 3),
+    .stack_size = memory::peek(img_key, img_offset + 4),
+    .entry      = memory::peek(img_key, img_offset + 5),
+  };
+}
+
+/*
+ * Brings a program's RAM to its initial state: copies in the initialized data
+ * image, zeroes the rest, and relocates the GOT.  Used both to load a program
+ * and to reinitialize it after a fault.
+ */
+static void init_ram(Header const & hdr,
+                     uintptr_t img_addr,
+                     KeyIndex img_key,
+                     uint32_t img_offset,
+                     KeyIndex k_ram,
+                     size_t ram_bytes) {
+  // Copy the data initialization image (including the GOT image) into RAM.
+  auto text_words = hdr.text_end / sizeof(uint32_t);
+  auto data_words = (hdr.image_size / sizeof(uint32_t)) - text_words;
+  {
+    // A multiple of the peek and poke batch sizes.
+    uint32_t buffer[15];
+    for (unsigned d_off = 0; d_off < data_words;
+         d_off += etl::array_count(buffer)) {
+      auto n = etl::min(data_words - d_off, etl::array_count(buffer));
+      memory::peek_multiple(img_key, img_offset + text_words + d_off,
+          buffer, n);
+      memory::poke_multiple(k_ram, d_off, buffer, n);
+    }
+  }
+
+  // Zero the rest.
+  auto ram_words = ram_bytes / sizeof(uint32_t);
+  {
+    static constexpr uint32_t zeros[3] {};
+    for (unsigned d_off = data_words; d_off < ram_words;
+         d_off += etl::array_count(zeros)) {
+      memory::poke_multiple(k_ram, d_off, zeros,
+          etl::min(ram_words - d_off, etl::array_count(zeros)));
+    }
+  }
+
+  // Relocate the GOT.
+  auto got_words = (hdr.got_end / sizeof(uint32_t)) - text_words;
+  auto ram_base = memory::inspect(k_ram).get_base();
+  for (unsigned d_off = 0; d_off < got_words; ++d_off) {
+    auto entry = memory::peek(k_ram, d_off);
+    memory::poke(k_ram, d_off,
+        relocate_got_entry(hdr, img_addr, ram_base, entry));
+  }
+}
+
+
+/*******************************************************************************
+ * Loaded programs.
+ */
+
+// Brands used for our own keys to a program's image and RAM.
+static constexpr uint64_t img_brand =
+  uint32_t(Rasr().with_ap(Mpu::AccessPermissions::p_read_u_read)) >> 8;
+static constexpr uint64_t ram_brand =
+  uint32_t(Rasr().with_ap(Mpu::AccessPermissions::p_write_u_write)) >> 8;
+
+/*
+ * What we need to know to reinitialize a program: where its image is, and
+ * which Memory holds its image and RAM.  Programs can't split, merge, or free
+ * the Memory they're given, so the table indices stay valid for as long as the
+ * program exists.
+ */
+struct Program {
+  TableIndex ctx_oti;
+  TableIndex img_oti;
+  TableIndex ram_oti;
+  uintptr_t img_addr;
+};
+
+static Program programs[config::max_program_count];
+static unsigned program_count;
+
 /*
  * Attempts to load a program from an image at address 'img_addr'.  The image
  * must be completely contained within the Memory object designated by
@@ -150,6 +252,9 @@ Maybe<rt::AutoKey> load_program(uintptr_t img_addr, KeyIndex img_key) {
   // Require the img_addr to be word-aligned.
   if (img_addr & 3) return nothing;
 
+  // We must be able to reinitialize the program if it faults.
+  if (program_count == etl::array_count(programs)) return nothing;
+
   // TODO: img_key is presumably coming from an untrusted source.  It's not
   // safe (from a DoS perspective) to make blocking calls against it, and
   // particularly unsafe to assert on their results.  We need some way of
@@ -169,28 +274,20 @@ Maybe<rt::AutoKey> load_program(uintptr_t img_addr, KeyIndex img_key) {
 
   // The image is completely contained by the given Memory object.  Hooray!
   // Now we can load a copy of the header into local memory.
-  auto hdr = Header {
-    .image_size = img_size,
-    .text_end   = memory::peek(img_key, img_offset + 1),
-    .got_end    = memory::peek(img_key, img_offset + 2),
-    .bss_end    = memory::peek(img_key, img_offset + 3),
-    .stack_size = memory::peek(img_key, img_offset + 4),
-    .entry      = memory::peek(img_key, img_offset + 5),
-  };
+  auto hdr = read_header(img_key, img_offset);
 
   // Perform basic header validation.
   if (!is_valid(hdr)) return nothing;
 
   // Allocate the required amount of RAM.
   auto ram_bytes = get_ram_size(hdr);
-  auto ram_l2_size = __builtin_ctz(ram_bytes);
-  auto maybe_k_ram = alloc_mem(ram_l2_size - 1,
-      uint32_t(Rasr().with_ap(Mpu::AccessPermissions::p_write_u_write)) >> 8);
+  auto ram_l2_size = __builtin_ctz(round_up_p2(ram_bytes));
+  auto maybe_k_ram = alloc_mem(ram_l2_size - 1, ram_brand);
   if (!maybe_k_ram) return nothing;
   auto & k_ram = maybe_k_ram.ref();
 
   // Allocate RAM for Context.
-  auto maybe_k_ctx = alloc_mem(kabi::context_l2_size - 1, 0);
+  auto maybe_k_ctx = alloc_body_mem(kabi::context_size);
   if (!maybe_k_ctx) {
     free_mem(k_ram);
     return nothing;
@@ -199,30 +296,14 @@ Maybe<rt::AutoKey> load_program(uintptr_t img_addr, KeyIndex img_key) {
 
   memory::become(k_ctx, memory::ObjectType::context, 0);
 
-  // Note: resources consumed, should not fail past this point if possible.
-
-  // Copy the data initialization image (including the GOT image) into RAM.
-  auto text_words = hdr.text_end / sizeof(uint32_t);
-  auto data_words = (hdr.image_size / sizeof(uint32_t)) - text_words;
-  for (unsigned d_off = 0; d_off < data_words; ++d_off) {
-    auto word = memory::peek(img_key, img_offset + text_words + d_off);
-    memory::poke(k_ram, d_off, word);
-  }
+  // Give back any part of the RAM block the program doesn't need.
+  trim_mem(k_ram, ram_bytes);
 
-  // Zero the rest.
-  auto ram_words = ram_bytes / sizeof(uint32_t);
-  for (unsigned d_off = data_words; d_off < ram_words; ++d_off) {
-    memory::poke(k_ram, d_off, 0);
-  }
+  // Note: resources consumed, should not fail past this point if possible.
 
-  // Relocate the GOT.
-  auto got_words = (hdr.got_end / sizeof(uint32_t)) - text_words;
+  init_ram(hdr, img_addr, img_key, img_offset, k_ram, ram_bytes);
   auto ram_region = memory::inspect(k_ram);
-  for (unsigned d_off = 0; d_off < got_words; ++d_off) {
-    auto entry = memory::peek(k_ram, d_off);
-    memory::poke(k_ram, d_off,
-        relocate_got_entry(hdr, img_addr, ram_region.get_base(), entry));
-  }
+  auto ram_words = ram_bytes / sizeof(uint32_t);
 
   // Fill out the stack frame.
   memory::poke(k_ram, ram_words - 1, 1 << 24);  // PSR
@@ -236,8 +317,43 @@ Maybe<rt::AutoKey> load_program(uintptr_t img_addr, KeyIndex img_key) {
       ram_region.get_base());
   context::set_register(k_ctx, context::Register::sp,
       ram_region.get_base() + ram_bytes - sizeof(etl::armv7m::ExceptionFrame));
+  context::save_restart_state(k_ctx, hdr.entry + img_addr);
+
+  // Route faults to the syscall server.
+  {
+    auto ctx_info = object_table::read_key(ki::ot, k_ctx);
+    auto k_supervisor = gate::make_client_key(ki::syscall_gate,
+        (Brand(1) << 63) | fault_brand_bit | ctx_info.index);
+    context::set_supervisor(k_ctx, k_supervisor);
+
+    programs[program_count++] = {
+      ctx_info.index,
+      object_table::read_key(ki::ot, img_key).index,
+      object_table::read_key(ki::ot, k_ram).index,
+      img_addr,
+    };
+  }
 
   return etl::move(k_ctx);
 }
 
+bool reinit_program(TableIndex ctx_oti) {
+  for (unsigned i = 0; i < program_count; ++i) {
+    auto & p = programs[i];
+    if (p.ctx_oti != ctx_oti) continue;
+
+    auto img_key = object_table::mint_key(ki::ot, p.img_oti, img_brand);
+    auto k_ram = object_table::mint_key(ki::ot, p.ram_oti, ram_brand);
+
+    // The header was checked at load time, and the image is in ROM, so it
+    // can be trusted to be the same.
+    auto img_offset = uint32_t(p.img_addr - memory::inspect(img_key).get_base())
+        / sizeof(uint32_t);
+    auto hdr = read_header(img_key, img_offset);
+    init_ram(hdr, p.img_addr, img_key, img_offset, k_ram, get_ram_size(hdr));
+    return true;
+  }
+  return false;
+}
+
 }  // namespace sys
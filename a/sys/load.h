@@ -7,8 +7,24 @@
 
 namespace sys {
 
+/*
+ * Loaded programs report faults to the syscall gate, through a key whose brand
+ * has this bit set.  As with syscall keys, the low 16 bits of the brand hold
+ * the Object Table index of the program's Context.
+ */
+static constexpr uint64_t fault_brand_bit = uint64_t(1) << 16;
+
 Maybe<rt::AutoKey> load_program(uintptr_t img_addr, KeyIndex img_key);
 
+/*
+ * Returns the RAM of the program whose Context is at table index 'ctx_oti' to
+ * the state it had when loaded: initialized data copied afresh from the image,
+ * BSS and stack zeroed, and the GOT relocated.  This doesn't touch the
+ * Context; the caller will usually restart it next.  Returns false if no such
+ * program was loaded.
+ */
+bool reinit_program(TableIndex ctx_oti);
+
 }  // namespace sys
 
 #endif  // A_SYS_LOAD_H
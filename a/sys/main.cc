@@ -52,6 +52,8 @@ constexpr AppInfo app_info {
 
   .memory_map_count = config::memory_map_count,
   .device_map_count = config::device_map_count,
+  .memory_run_count = config::app_ram.run_count(),
+  .boot_object_count = config::boot_object_count,
   .extra_slot_count = config::extra_slot_count,
   .external_interrupt_count = config::external_interrupt_count,
 
@@ -62,51 +64,66 @@ constexpr AppInfo app_info {
 
   .initial_task_grants = {
     {  // ROM
-      .memory_index = kabi::well_known_object_count + 0,
+      .memory_index = config::table.first_memory() + 0,
       .brand = uint32_t(Rasr()
           .with_ap(Mpu::AccessPermissions::p_read_u_read)) >> 8,
     },
     {  // RAM
-      .memory_index = kabi::well_known_object_count + 1,
+      .memory_index = config::table.first_memory() + 1,
       .brand = uint32_t(Rasr()
           .with_ap(Mpu::AccessPermissions::p_write_u_write)
           .with_xn(true)) >> 8,
     },
   },
 
+  // Application RAM, pre-split by the kernel for our allocator, and objects
+  // we'd otherwise make first thing.  See peanut_config.h.
+  .memory_runs = {
+    config::app_ram.run(
+        reinterpret_cast<uint32_t>(&_app_ram1_start), 0),
+    config::app_ram.run(
+        reinterpret_cast<uint32_t>(&_app_ram1_start), 1),
+    config::app_ram.run(
+        reinterpret_cast<uint32_t>(&_app_ram1_start), 2),
+    config::app_ram.run(
+        reinterpret_cast<uint32_t>(&_app_ram1_start), 3),
+  },
+
+  .boot_object_types = {
+    layout::boot_type(config::boot_objects, 0),
+    layout::boot_type(config::boot_objects, 1),
+    layout::boot_type(config::boot_objects, 2),
+    layout::boot_type(config::boot_objects, 3),
+    layout::boot_type(config::boot_objects, 4),
+    layout::boot_type(config::boot_objects, 5),
+    layout::boot_type(config::boot_objects, 6),
+    layout::boot_type(config::boot_objects, 7),
+  },
+
   .memory_map = {},
 };
 
-static constexpr size_t object_table_count =
-  kabi::well_known_object_count
-  + config::memory_map_count
-  + config::device_map_count
-  + config::extra_slot_count;
-
-__attribute__((section(".donated_ram")))
-uint8_t kernel_donation[
-  kabi::context_size  // first context
-  + kabi::object_head_size * object_table_count  // Object Table
-  + sizeof(void *) * (1 + config::external_interrupt_count)];
+static_assert(layout::max_runs == 4
+              && sizeof(AppInfo::boot_object_types) == 8 * sizeof(uint32_t),
+    "AppInfo tables changed size; update the initializers above");
 
 static constexpr unsigned
-  oi_sys_rom = kabi::well_known_object_count + 0,
-  oi_app_ram = kabi::well_known_object_count + 2,
-  oi_apb = kabi::well_known_object_count + 3;
+  oi_sys_rom = config::table.first_memory() + 0,
+  oi_apb = config::table.first_device() + 0,
+  oi_first_run_block = config::table.first_run_block(),
+  oi_syscall_gate = config::table.first_boot_object() + 0,
+  oi_idle_context = config::table.first_boot_object() + 1;
 
+static_assert(config::boot_objects[0] == memory::ObjectType::gate
+              && config::boot_objects[1] == memory::ObjectType::context,
+    "sys expects its syscall gate and idle task as the first boot objects");
 
-/*******************************************************************************
- * Factored out bits.
- */
+static constexpr size_t object_table_count = config::table.size();
 
-/*
- * Allocates a fresh Gate.
- */
-static rt::AutoKey make_gate() {
-  auto k = etl::move(alloc_mem(kabi::gate_l2_size - 1, 0).ref());
-  memory::become(k, memory::ObjectType::gate, 0);
-  return k;
-}
+__attribute__((section(".donated_ram")))
+uint8_t kernel_donation[config::table.donation_size(
+    config::external_interrupt_count,
+    layout::boot_body_total(config::boot_objects))];
 
 
 /*******************************************************************************
@@ -114,12 +131,18 @@ static rt::AutoKey make_gate() {
  */
 
 static void feed_allocator() {
-  // Mint a key to the application RAM object described above.
-  auto k_app_ram = object_table::mint_key(ki::ot, oi_app_ram, 0);
-  // Hand said object over to the allocator.
-  bool freed = free_mem(k_app_ram);
-  // If the allocator doesn't take it, we have a bug!
-  ETL_ASSERT(freed);
+  // The kernel made the memory runs' blocks for us, in order, so we can hand
+  // them to the allocator without asking about them.
+  auto oti = oi_first_run_block;
+  for (unsigned r = 0; r < app_info.memory_run_count; ++r) {
+    auto & run = app_info.memory_runs[r];
+    for (unsigned i = 0; i < run.count; ++i) {
+      seed_mem(run.l2_half_size,
+               run.base + i * (2u << run.l2_half_size),
+               oti++);
+    }
+  }
+  ETL_ASSERT(oti == oi_syscall_gate);
 }
 
 static void make_self_key() {
@@ -130,11 +153,8 @@ static void make_self_key() {
 }
 
 static void make_idle_task() {
-  // Allocate space for a Context.
-  auto k_ctx = etl::move(alloc_mem(kabi::context_l2_size - 1, 0).ref());
-
-  // Make it into a real Context.
-  memory::become(k_ctx, memory::ObjectType::context, 0);
+  // The kernel made the Context at boot.
+  auto k_ctx = object_table::mint_key(ki::ot, oi_idle_context, 0);
 
   prepare_idle_task(k_ctx);
 
@@ -143,10 +163,17 @@ static void make_idle_task() {
 }
 
 static void make_syscall_gate() {
-  auto k = make_gate();
+  // The kernel made the Gate at boot.
+  auto k = object_table::mint_key(ki::ot, oi_syscall_gate, 0);
   rt::copy_key(ki::syscall_gate, k);
 }
 
+static void make_table_view() {
+  // Region registers 0 and 1 hold our grants.
+  bool mapped = map_table_view(object_table_count, 2);
+  ETL_ASSERT(mapped);
+}
+
 
 /*******************************************************************************
  * Syscall server.
@@ -214,6 +241,22 @@ static void serve_syscalls() {
     // TODO: eventually, we'll need to behave differently based on brand, e.g.
     // for interrupts.
 
+    // Fault reports from loaded programs carry a service key to the faulting
+    // Context.  Fail any callers it was serving, so they can retry, and
+    // restart the program from the top, which also discards the reply key.
+    //
+    // The fault may have left the program's data in any state, so it's
+    // reloaded from the image first.  The Context may also have been destroyed
+    // since it faulted, leaving the key dead; then there's nothing to restart.
+    if (brand & fault_brand_bit) {
+      if (context::abandon_reply_keys(k_tmp1)) {
+        reinit_program(uint32_t(brand) & 0xFFFF);
+        context::restart(k_tmp1);
+      }
+      msg.desc = base_receive_descriptor;
+      continue;
+    }
+
     // The OTI of the caller's context is given by the low 16 bits of the
     // brand.   Extract it.
     auto caller_oti = uint32_t(brand) & 0xFFFF;
@@ -258,6 +301,7 @@ static void main() {
 
   feed_allocator();
   make_self_key();
+  make_table_view();
   make_syscall_gate();
   make_idle_task();
 
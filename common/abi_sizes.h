@@ -21,12 +21,20 @@ static constexpr unsigned
 
 /*
  * Size of kernel objects and Object Table entries, in bytes.
+ *
+ * Contexts are mostly keys, so their size depends on the key representation
+ * (see k/key.h).
  */
 static constexpr unsigned
   object_head_size = 32,  // object table entry size
-  context_size = 448,
+#ifdef KERNEL_COMPACT_KEYS
+  context_size = 344,
+#else
+  context_size = 536,
+#endif
   gate_size = k::config::n_priorities * 16,
-  interrupt_size = 48;
+  interrupt_size = 48,
+  timer_size = 40;
 
 constexpr unsigned log2floor(unsigned x) {
   return (x < 2) ? 0
@@ -47,7 +55,8 @@ constexpr unsigned allocsize(unsigned x) {
 static constexpr unsigned
   context_l2_size = allocsize(context_size),
   gate_l2_size = allocsize(gate_size),
-  interrupt_l2_size = allocsize(interrupt_size);
+  interrupt_l2_size = allocsize(interrupt_size),
+  timer_l2_size = allocsize(timer_size);
 
 }  // namespace kabi
 
@@ -5,7 +5,7 @@
 
 #include "abi_types.h"
 
-static constexpr uint32_t current_abi_token = 0xca11ab1e;
+static constexpr uint32_t current_abi_token = 0xb007ab1e;
 
 /*
  * Describes the application's kernel interface.  An instance of this should be
@@ -25,10 +25,15 @@ struct AppInfo {
   uint32_t memory_map_count;
   // Number of device memory objects in the map.
   uint32_t device_map_count;
+  // Number of entries used in memory_runs, below.
+  uint32_t memory_run_count;
+  // Number of entries used in boot_object_types, below.
+  uint32_t boot_object_count;
   // Number of extra free object table slots desired.  The number of slots in
   // the object table will be given by:
-  //   well_known_object_count + memory_map_count
-  //       + device_map_count + extra_slot_count;
+  //   well_known_object_count + memory_map_count + device_map_count
+  //       + (total blocks in memory_runs) + boot_object_count
+  //       + extra_slot_count;
   uint32_t extra_slot_count;
 
   // Number of external interrupts that may be handled.  This determines the
@@ -61,6 +66,29 @@ struct AppInfo {
   // Table of memory grants for initial task.  (The number 4 here is arbitrary.)
   MemGrant initial_task_grants[4];
 
+  // Structure of a memory run: a span of address space that the kernel
+  // creates, already split, as 'count' Memory objects of 2^(l2_half_size+1)
+  // bytes each, starting at 'base'.  This saves the application from having to
+  // split a large Memory object into allocator-sized blocks at startup.
+  //
+  // 'base' must be aligned to the block size, and l2_half_size must be at
+  // least 4, so that each block is mappable.  Runs must not overlap each other
+  // or the memory map.
+  struct MemoryRun {
+    uint32_t base;
+    uint32_t l2_half_size;
+    uint32_t count;
+  };
+  // Table of memory runs.  (The number 4 here is arbitrary.)  Their Memory
+  // objects follow those of the memory map in the object table, in order.
+  MemoryRun memory_runs[4];
+
+  // Type codes (as for Memory's Become method) of objects the kernel should
+  // create at boot, with bodies taken from donated RAM.  Only Contexts and
+  // Gates are supported.  These follow the memory runs' objects in the object
+  // table.  (The number 8 here is arbitrary.)
+  uint32_t boot_object_types[8];
+
   // An entry in the Memory Map (below).
   struct MemoryMapEntry {
     // Base address of memory map entry.
@@ -81,6 +81,25 @@ enum class Exception : uint64_t {
    * generation rollover.
    */
   causality = 0x402a370053d833a6,
+
+  /*
+   * The object that was expected to reply to you gave up on the request, e.g.
+   * because the server was restarted, or a Gate you were blocked on was
+   * discharged.  The request may or may not have taken effect.
+   */
+  abandoned = 0x03ef90dcd1be4bd7,
+
+  /*
+   * A kernel-managed pool (such as the Object Table's free Slots) has nothing
+   * left to give.
+   */
+  exhausted = 0x1456e17b3421ad53,
+
+  /*
+   * The operation would move, reshape, or revoke a Memory object that has been
+   * locked, e.g. because a DMA transfer is using it.
+   */
+  locked = 0x077ee5960ad800f3,
 };
 
 #endif  // COMMON_EXCEPTIONS_H
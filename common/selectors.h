@@ -19,18 +19,28 @@ namespace context {
     read_low_registers = 10,
     read_high_registers = 11,
     write_low_registers = 12,
-    write_high_registers = 13;
+    write_high_registers = 13,
+    save_restart_state = 14,
+    restart = 15,
+    set_supervisor = 16,
+    enumerate_reply_keys = 17,
+    abandon_reply_keys = 18,
+    destroy = 19,
+    set_region_cache = 20;
 }
 
 namespace gate {
   static constexpr Selector
-    make_client_key = 1;
+    make_client_key = 1,
+    discharge_one = 2,
+    destroy = 3;
 }
 
 namespace interrupt {
   static constexpr Selector
     set_target = 1,
-    enable = 2;
+    enable = 2,
+    destroy = 3;
 }
 
 namespace memory {
@@ -41,7 +51,37 @@ namespace memory {
     become = 4,
     peek = 5,
     poke = 6,
-    make_child = 7;
+    make_child = 7,
+    become_array = 8,
+    split_multiple = 9,
+    merge = 10,
+    peek_multiple = 11,
+    poke_multiple = 12,
+    lock = 13,
+    unlock = 14;
+}
+
+// Messages sent by the kernel to a Context's supervisor.
+namespace supervisor {
+  static constexpr Selector
+    fault = 1;
+}
+
+namespace keyring {
+  static constexpr Selector
+    load = 1,
+    store = 2,
+    get_size = 3,
+    destroy = 4;
+}
+
+namespace timer {
+  static constexpr Selector
+    set_target = 1,
+    arm = 2,
+    disarm = 3,
+    read_clock = 4,
+    destroy = 5;
 }
 
 namespace object_table {
@@ -49,7 +89,12 @@ namespace object_table {
     mint_key = 1,
     read_key = 2,
     get_kind = 3,
-    invalidate = 4;
+    invalidate = 4,
+    mint_keys = 5,
+    read_kinds = 6,
+    alloc_slot = 7,
+    free_slot = 8,
+    set_table_view = 9;
 }
 
 }  // namespace selector
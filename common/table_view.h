@@ -0,0 +1,31 @@
+#ifndef COMMON_TABLE_VIEW_H
+#define COMMON_TABLE_VIEW_H
+
+#include <cstdint>
+
+/*
+ * Layout of the Object Table view, which the kernel maintains in a Memory
+ * object nominated by the system (see the Object Table's Set Table View
+ * method).  The view holds one entry per Object Table index, in order.
+ *
+ * The kernel updates an entry whenever the object at its index is created,
+ * replaced, or invalidated, so a program that maps the view can learn an
+ * object's kind, generation, and (for Memory) extent using ordinary loads.
+ */
+struct TableViewEntry {
+  // Kind of the object, using the same numbering as the Object Table's Get
+  // Kind method.
+  uint32_t kind;
+  // Generation of the object.  Keys bearing a different generation have been
+  // revoked.
+  uint32_t generation;
+  // For Memory objects, the base address and size in bytes.  Zero for other
+  // kinds.
+  uint32_t base;
+  uint32_t size;
+};
+
+static_assert(sizeof(TableViewEntry) == 16,
+    "TableViewEntry layout is part of the ABI");
+
+#endif  // COMMON_TABLE_VIEW_H
@@ -1,5 +1,6 @@
 #include "k/app.h"
 
+#include "etl/array_count.h"
 #include "etl/mem/arena.h"
 
 #include "etl/armv7m/exception_table.h"
@@ -11,6 +12,7 @@
 #include "common/app_info.h"
 #include "common/abi_sizes.h"
 
+#include "k/become.h"
 #include "k/memory.h"
 #include "k/context.h"
 #include "k/gate.h"
@@ -90,7 +92,8 @@ static void initialize_well_known_objects(RangePtr<ObjectTable::Entry> entries,
 
   {
     auto b = new(arena.allocate(kabi::context_size)) Context::Body;
-    first_context = new(&entries[2]) Context{0, *b};
+    first_context =
+      new(&entries[2]) Context{0, *b, kabi::context_size};
   }
 }
 
@@ -157,10 +160,70 @@ static void create_memory_objects(RangePtr<ObjectTable::Entry> entries) {
 }
 
 /*
- * Fills the given range with Slot objects.
+ * Counts the Memory objects described by AppInfo's memory runs.
+ */
+static unsigned count_memory_run_blocks() {
+  auto & app = get_app_info();
+  ALWAYS_PANIC_UNLESS(
+      app.memory_run_count <= etl::array_count(app.memory_runs),
+      "too many memory runs");
+
+  unsigned total = 0;
+  for (unsigned r = 0; r < app.memory_run_count; ++r) {
+    total += app.memory_runs[r].count;
+  }
+  return total;
+}
+
+/*
+ * Creates the Memory objects described by AppInfo's memory runs, one per
+ * block, so that the application's allocator needn't split them itself.
+ */
+static void create_memory_runs(RangePtr<ObjectTable::Entry> entries) {
+  auto & app = get_app_info();
+
+  unsigned next = 0;
+  for (unsigned r = 0; r < app.memory_run_count; ++r) {
+    auto & run = app.memory_runs[r];
+
+    ALWAYS_PANIC_UNLESS(run.l2_half_size >= 4 && run.l2_half_size < 31,
+                        "bad memory run block size");
+    uint32_t block_size = 2u << run.l2_half_size;
+    ALWAYS_PANIC_UNLESS((run.base & (block_size - 1)) == 0,
+                        "misaligned memory run");
+
+    // TODO: as for the memory map, check that this does not alias the kernel.
+
+    for (unsigned i = 0; i < run.count; ++i) {
+      (void) new(&entries[next++])
+        Memory{0, run.base + i * block_size, block_size, 0};
+    }
+  }
+}
+
+/*
+ * Creates the objects described by AppInfo's boot object table, allocating
+ * their bodies from donated RAM.
+ */
+static void create_boot_objects(RangePtr<ObjectTable::Entry> entries,
+                                Arena & arena) {
+  auto & app = get_app_info();
+
+  for (unsigned i = 0; i < entries.count(); ++i) {
+    auto type_code = app.boot_object_types[i];
+    auto body_size = boot_body_size(type_code);
+    ALWAYS_PANIC_UNLESS(body_size, "bad boot object type");
+    construct_boot_object(type_code, &entries[i], arena.allocate(body_size));
+  }
+}
+
+/*
+ * Fills the given range with Slot objects, and makes them available from the
+ * Object Table's free list.
  */
 static void fill_extra_slots(RangePtr<ObjectTable::Entry> entries) {
-  for (auto & ent : entries) (void) new(&ent) Slot{0};
+  auto & ot = object_table();
+  for (auto & ent : entries) ot.add_free_slot(*new(&ent) Slot{0});
 }
 
 
@@ -233,9 +296,16 @@ static void initialize_app() {
   // Shorthand for wordy ABI constant:
   constexpr auto wkoc = kabi::well_known_object_count;
 
-  // Compute required size of Object Table.
-  auto table_size =
-    wkoc + app.memory_map_count + app.device_map_count + app.extra_slot_count;
+  ALWAYS_PANIC_UNLESS(
+      app.boot_object_count <= etl::array_count(app.boot_object_types),
+      "too many boot objects");
+
+  // Compute the layout of the Object Table: well-known objects, memory map,
+  // memory runs, boot objects, and extra slots, in that order.
+  auto runs_begin = wkoc + app.memory_map_count + app.device_map_count;
+  auto boot_begin = runs_begin + count_memory_run_blocks();
+  auto slots_begin = boot_begin + app.boot_object_count;
+  auto table_size = slots_begin + app.extra_slot_count;
 
   // Use the Arena to create the Object Table's entry array.
   auto entries = 
@@ -258,10 +328,10 @@ static void initialize_app() {
 
   // Set up the initial object zoo.
   initialize_well_known_objects(entries, arena);
-  create_memory_objects(
-      entries.slice(wkoc, table_size - app.extra_slot_count));
-  fill_extra_slots(
-      entries.slice(table_size - app.extra_slot_count, table_size));
+  create_memory_objects(entries.slice(wkoc, runs_begin));
+  create_memory_runs(entries.slice(runs_begin, boot_begin));
+  create_boot_objects(entries.slice(boot_begin, slots_begin), arena);
+  fill_extra_slots(entries.slice(slots_begin, table_size));
   prepare_first_context();
 }
 
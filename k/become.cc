@@ -10,6 +10,7 @@
 #include "k/context.h"
 #include "k/gate.h"
 #include "k/interrupt.h"
+#include "k/keyring.h"
 #include "k/memory.h"
 #include "k/object_table.h"
 #include "k/region.h"
@@ -17,6 +18,7 @@
 #include "k/scheduler.h"
 #include "k/sender.h"
 #include "k/slot.h"
+#include "k/timer.h"
 
 using etl::armv7m::Mpu;
 
@@ -26,80 +28,281 @@ enum class TypeCode {
   context = 0,
   gate = 1,
   interrupt = 2,
+  timer = 3,
+  keyring = 4,
 };
 
+/*
+ * Object bodies are constructed in place at the base of the donated Memory,
+ * which therefore must be aligned suitably for any of them.  Note that this is
+ * the only constraint on the Memory's shape: bodies aren't mapped, so they
+ * needn't be a power of two in size or naturally aligned, and can be carved to
+ * size from a larger Memory using Split.
+ */
+static constexpr uintptr_t body_alignment = 8;
+
+static_assert(alignof(Context::Body) <= body_alignment, "");
+static_assert(alignof(Gate::Body) <= body_alignment, "");
+static_assert(alignof(Interrupt::Body) <= body_alignment, "");
+static_assert(alignof(Timer::Body) <= body_alignment, "");
+static_assert(alignof(Key) <= body_alignment, "");
+
 static unsigned size_for_type_code(TypeCode tc) {
   switch (tc) {
     case TypeCode::context:   return kabi::context_size;
     case TypeCode::gate:      return kabi::gate_size;
     case TypeCode::interrupt: return kabi::interrupt_size;
+    case TypeCode::timer:     return kabi::timer_size;
+    case TypeCode::keyring:   return sizeof(Key);  // minimum; see below
 
     // Other values are supposed to have been filtered out before this point.
     default: PANIC("become TC validation fail");
   }
 }
 
+/*
+ * Checks the conditions on 'memory' common to become and become_array.
+ */
+static bool can_donate(Memory & memory) {
+  return !memory.is_device()
+      && !memory.child_count()
+      && !memory.parent()
+      && (memory.get_base() & (body_alignment - 1)) == 0;
+}
+
+/*
+ * Constructs an object of the given type, placing its head at 'head' and its
+ * body in 'body_size' bytes at 'bodymem'.
+ *
+ * Precondition: 'head' is a table entry with no living object in it.
+ */
+static Object * construct(TypeCode type_code,
+                          void * head,
+                          Generation generation,
+                          void * bodymem,
+                          size_t body_size,
+                          uint32_t arg) {
+  switch (type_code) {
+    case TypeCode::context:
+      {
+        auto b = new(bodymem) Context::Body;
+        return new(head) Context{generation, *b, body_size};
+      }
+    case TypeCode::gate:
+      {
+        auto b = new(bodymem) Gate::Body;
+        return new(head) Gate{generation, *b, body_size};
+      }
+    case TypeCode::interrupt:
+      {
+        auto b = new(bodymem) Interrupt::Body{arg};
+        return new(head) Interrupt{generation, *b, body_size};
+      }
+    case TypeCode::timer:
+      {
+        auto b = new(bodymem) Timer::Body;
+        return new(head) Timer{generation, *b, body_size};
+      }
+    case TypeCode::keyring:
+      {
+        // Keyrings use all the memory they're given.
+        auto count = body_size / sizeof(Key);
+        auto keys = static_cast<Key *>(bodymem);
+        for (size_t i = 0; i < count; ++i) new(&keys[i]) Key{};
+        return new(head) Keyring{generation, {keys, count}, body_size};
+      }
+  }
+  PANIC("become TC validation fail");
+}
+
+size_t boot_body_size(uint32_t type_code) {
+  // Contexts and Gates need no argument, which keeps the AppInfo table simple.
+  if (type_code == uint32_t(TypeCode::context)
+      || type_code == uint32_t(TypeCode::gate)) {
+    return size_for_type_code(TypeCode(type_code));
+  }
+  return 0;
+}
+
+void construct_boot_object(uint32_t type_code, void * head, void * body) {
+  auto body_size = boot_body_size(type_code);
+  PANIC_UNLESS(body_size, "bad boot object type");
+  (void) construct(TypeCode(type_code), head, 0, body, body_size, 0);
+}
+
 void become(Memory & memory,
             Message const & m,
             Keys & k,
             ReplySender & reply_sender) {
-  if (memory.is_device() || memory.child_count() || memory.parent()
-      || !memory.is_mappable()) {
+  if (!can_donate(memory)) {
     // Can't transmogrify, this is wrong.
-    // TODO mappability requirement is temporary
     reply_sender.message() = Message::failure(Exception::bad_operation);
     return;
   }
 
-  if (m.d0 > uint32_t(TypeCode::interrupt)) {
+  if (m.d0 > uint32_t(TypeCode::keyring)) {
     // Can't transmogrify, target object type not recognized.
     reply_sender.message() = Message::failure(Exception::bad_argument);
     return;
   }
   auto type_code = static_cast<TypeCode>(m.d0);
 
+  if (memory.is_generation_near_wrap()) {
+    // Can't transmogrify without risking resurrection of old keys.
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+
   if (size_for_type_code(type_code) > memory.get_size()) {
     // Can't transmogrify, memory too small.
     reply_sender.message() = Message::failure(Exception::bad_operation);
     return;
   }
 
+  if (type_code == TypeCode::keyring
+      && memory.get_size() / sizeof(Key) > config::max_keyring_keys) {
+    // Can't transmogrify in bounded time; the caller should split first.
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
   auto new_generation = memory.get_generation() + 1;
 
   // At this point it becomes dangerous (or at least suspicious) to use
   // 'memory' in any way, since we're going to start rewriting it shortly.
 
   auto bodymem = reinterpret_cast<void *>(memory.get_base());
-  Object * newobj;
+  auto body_size = memory.get_size();
 
   etl::destroy(memory);
 
-  switch (type_code) {
-    case TypeCode::context:
-      {
-        auto b = new(bodymem) Context::Body;
-        newobj = new(&memory) Context{new_generation, *b};
-        break;
-      }
-    case TypeCode::gate:
-      {
-        auto b = new(bodymem) Gate::Body;
-        newobj = new(&memory) Gate{new_generation, *b};
-        break;
-      }
-    case TypeCode::interrupt:
-      {
-        auto b = new(bodymem) Interrupt::Body{m.d1};
-        newobj = new(&memory) Interrupt{new_generation, *b};
-        break;
-      }
-  }
+  auto newobj = construct(type_code, &memory, new_generation,
+                          bodymem, body_size, m.d1);
+
   // Provide a key to the new object.
   reply_sender.set_key(1, newobj->make_key(0).ref());  // TODO brand?
 
   // Update MPU, in case the transmogrified object was in the current Context's
   // memory map.
-  current->apply_to_mpu();
+  current->apply_to_mpu_for(*newobj);
+}
+
+void become_array(Memory & memory,
+                  Brand const & brand,
+                  Message const & m,
+                  Keys & k,
+                  ReplySender & reply_sender) {
+  if (!can_donate(memory)) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  auto count = m.d1;
+
+  // Interrupts each need their own vector, and Keyrings have no fixed size
+  // (and may each take up to config::max_keyring_keys to initialize), so
+  // neither is available in bulk.
+  if (m.d0 > uint32_t(TypeCode::keyring)
+      || m.d0 == uint32_t(TypeCode::interrupt)
+      || m.d0 == uint32_t(TypeCode::keyring)
+      || count == 0
+      || count > config::max_become_array) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+  auto type_code = static_cast<TypeCode>(m.d0);
+
+  // Round the body size up so that each body is aligned.
+  auto body_size =
+    (size_for_type_code(type_code) + body_alignment - 1) & ~(body_alignment - 1);
+
+  if (body_size * count > memory.get_size()) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  // The objects' heads go in consecutive Slots, starting with the one
+  // designated by k1.
+  auto & table = object_table();
+  auto first = k.keys[1].get();
+  if (first->get_kind() != Object::Kind::slot) {
+    reply_sender.message() = Message::failure(Exception::bad_kind);
+    return;
+  }
+
+  // A Slot key conveys authority over the Slots that follow it only as far as
+  // its brand says (see Slot), so a key to one Slot can't claim its
+  // neighbours.
+  if (count - 1 > k.keys[1].get_brand()) {
+    reply_sender.message() = Message::failure(Exception::bad_brand);
+    return;
+  }
+
+  auto first_index = table.index_of(*first);
+  if (count > table.size() - first_index) {
+    reply_sender.message() = Message::failure(Exception::index_out_of_range);
+    return;
+  }
+
+  for (unsigned i = 0; i < count; ++i) {
+    if (table[first_index + i].get_kind() != Object::Kind::slot) {
+      reply_sender.message() = Message::failure(Exception::bad_kind);
+      return;
+    }
+  }
+
+  // The Memory's generation is advanced too, since it shrinks.
+  if (memory.is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+  for (unsigned i = 0; i < count; ++i) {
+    if (table[first_index + i].is_generation_near_wrap()) {
+      reply_sender.message() = Message::failure(Exception::causality);
+      return;
+    }
+  }
+
+  // Commit point
+
+  auto base = memory.get_base();
+
+  for (unsigned i = 0; i < count; ++i) {
+    auto & slot = static_cast<Slot &>(table[first_index + i]);
+    auto new_generation = slot.get_generation() + 1;
+    etl::destroy(slot);
+
+    auto newobj = construct(type_code, &slot, new_generation,
+                            reinterpret_cast<void *>(base + i * body_size),
+                            body_size, 0);
+    if (i == 0) reply_sender.set_key(1, newobj->make_key(0).ref());
+  }
+
+  reply_sender.message().d0 = count;
+
+  auto used = body_size * count;
+  if (used == memory.get_size()) {
+    // Nothing remains.  Rather than leave an empty Memory, give its table
+    // entry back to the system as a free Slot, as Merge does -- unless it has
+    // worn out.
+    auto new_generation = memory.get_generation() + 1;
+    etl::destroy(memory);
+    auto slot = new(&memory) Slot{new_generation};
+    if (!slot->is_generation_near_wrap()) table.add_free_slot(*slot);
+
+    current->apply_to_mpu_for(*slot);
+    return;
+  }
+
+  // Shrink the Memory to cover what's left, revoking keys to the part that
+  // has been donated.
+  auto & rest = unbecome(memory, base + used, memory.get_size() - used,
+                         memory.get_attributes());
+  reply_sender.set_key(2, rest.make_key(brand).ref());
+
+  // Update MPU, in case the Memory was in the current Context's memory map.
+  // Only the Memory can be, for the same reasons as in Memory::do_split.
+  current->apply_to_mpu_for(rest);
 }
 
 }  // namespace k
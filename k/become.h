@@ -5,16 +5,94 @@
  * Operations for converting kernel objects between types.
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "etl/destroy.h"
+
 #include "common/message.h"
 
+#include "k/memory.h"
+#include "k/reply_sender.h"
+
 namespace k {
 
-struct Memory;  // see: k/memory.h
 struct Keys;  // see: k/keys.h
-struct ReplySender;  // see: k/reply_sender.h
 
 void become(Memory &, Message const &, Keys &, ReplySender &);
 
+/*
+ * Variant of become that creates several objects of the same type, with their
+ * heads in consecutive Slots and their bodies carved from the front of the
+ * Memory.  The Memory is left describing whatever remains.
+ */
+void become_array(Memory &, Brand const &, Message const &, Keys &,
+                  ReplySender &);
+
+/*
+ * Support for objects created at boot from the AppInfo boot object table.
+ * boot_body_size gives the body size needed for a type code, or zero if the
+ * type can't be created at boot.  construct_boot_object then creates the
+ * object, with its head at 'head' and its body at 'body'.
+ *
+ * Precondition (construct_boot_object): 'head' is a table entry with no living
+ * object in it, and boot_body_size(type_code) is non-zero.
+ */
+size_t boot_body_size(uint32_t type_code);
+void construct_boot_object(uint32_t type_code, void * head, void * body);
+
+/*
+ * Inverse of become: replaces 'obj' with a Memory object describing its body,
+ * which occupies 'size' bytes at 'base'.  The Memory's generation is one
+ * greater than the object's, so outstanding keys to the object are revoked.
+ * 'attributes' are given to the Memory as for its constructor.
+ *
+ * The caller must ensure that nothing inside the kernel refers to the object
+ * or its body -- e.g. that it's not on any lists, and owns no list that is
+ * non-empty.
+ */
+template <typename T>
+Memory & unbecome(T & obj, uintptr_t base, size_t size,
+                  uint32_t attributes = 0) {
+  auto new_generation = obj.get_generation() + 1;
+
+  etl::destroy(obj);
+  return *new(&obj) Memory{new_generation, base, size, attributes};
+}
+
+/*
+ * Common implementation of the Destroy method offered by objects made with
+ * become.  Invalidates 'obj', which detaches it from any lists and hardware it
+ * was using, and then replaces it with a Memory object describing its body.
+ * A key to the Memory is returned in k1.
+ *
+ * The caller must check any type-specific conditions first.
+ */
+template <typename T>
+void destroy_object(T & obj,
+                    void * body,
+                    size_t body_size,
+                    ScopedReplySender & reply_sender) {
+  if (obj.is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+
+  // Invalidation advances the generation, so the Memory can simply inherit it.
+  obj.invalidate();
+  auto generation = obj.get_generation();
+
+  etl::destroy(obj);
+  auto & memory = *new(&obj) Memory{generation,
+                                    reinterpret_cast<uintptr_t>(body),
+                                    body_size,
+                                    0};
+  // Note: 'obj' is no longer a T.
+
+  reply_sender.set_key(1, memory.make_key(0).ref());
+}
+
 }  // namespace k
 
 #endif  // K_BECOME_H
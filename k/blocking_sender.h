@@ -39,13 +39,14 @@ public:
 
   /*
    * Indicates that this object has been removed from a block list and its
-   * message is no longer of interest.
+   * message is no longer of interest.  The Exception explains why, and should
+   * be reported to the sender's code if it has any.
    *
    * This can be used to interrupt a pending sender.
    *
    * This ends the blocking send protocol.
    */
-  virtual void on_blocked_delivery_aborted() = 0;
+  virtual void on_blocked_delivery_aborted(Exception) = 0;
 };
 
 }  // namespace k
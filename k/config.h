@@ -10,6 +10,63 @@ static constexpr unsigned
   n_message_keys = 4,
   n_priorities = 2;
 
+/*
+ * Number of slots in the Timer wheel.  Timers whose deadlines are congruent
+ * modulo this number share a slot, so a larger wheel reduces the work done on
+ * each tick at the cost of kernel RAM.  Must be a power of two.
+ */
+static constexpr unsigned
+  n_timer_wheel_slots = 16;
+
+static_assert((n_timer_wheel_slots & (n_timer_wheel_slots - 1)) == 0,
+    "n_timer_wheel_slots must be a power of two");
+
+/*
+ * Objects whose generations are within this many invalidations of wrapping
+ * around are considered worn out.  Operations that would advance such a
+ * generation fail with a causality exception, since wrapping could resurrect
+ * old keys, and the Object Table retires worn-out Slots instead of reusing
+ * them.
+ */
+static constexpr unsigned
+  generation_guard = 256;
+
+/*
+ * MPU region used by the kernel to access Memory with the attributes given by
+ * a key, e.g. for peek and poke.  It's the highest-numbered region so that it
+ * takes priority over any aliases in the task regions.
+ */
+static constexpr unsigned
+  kernel_access_region = 7;
+
+static_assert(n_task_regions <= kernel_access_region,
+    "task regions must not overlap the kernel access region");
+
+/*
+ * Maximum number of objects created by a single Memory become_array
+ * operation.  The operation's time is linear in this.
+ */
+static constexpr unsigned
+  max_become_array = 16;
+
+/*
+ * Maximum number of keys in a Context's region cache Keyring.  The kernel
+ * searches the Keyring with interrupts masked when refilling the cache, so
+ * this bounds the time taken by a memory management fault.
+ */
+static constexpr unsigned
+  max_region_cache_keys = 16;
+
+/*
+ * Maximum number of keys in a Keyring.  Become initializes every key of a new
+ * Keyring with interrupts masked, so this bounds the time it takes.
+ */
+static constexpr unsigned
+  max_keyring_keys = 64;
+
+static_assert(max_region_cache_keys <= max_keyring_keys,
+    "region cache limit can never be reached");
+
 }  // namespace config
 }  // namespace k
 
@@ -12,13 +12,17 @@
 #include "common/selectors.h"
 #include "common/sysnums.h"
 
+#include "k/become.h"
 #include "k/memory.h"
 #include "k/context_layout.h"
+#include "k/dispatch.h"
+#include "k/keyring.h"
 #include "k/object_table.h"
 #include "k/panic.h"
 #include "k/registers.h"
 #include "k/reply_sender.h"
 #include "k/scheduler.h"
+#include "k/unprivileged.h"
 
 using etl::armv7m::Word;
 
@@ -45,9 +49,10 @@ static constexpr Brand reply_brand_mask = Brand(1) << 63;
  * Context-specific stuff
  */
 
-Context::Context(Generation g, Body & body)
-  : Object{g},
-    _body(body) {
+Context::Context(Generation g, Body & body, size_t body_size)
+  : Object{g, Kind::context},
+    _body(body),
+    _body_size(body_size) {
   // Had to do this somewhere, this is as good a place as any.
   // (The fields in question are private, so this can't be at top level.)
   static_assert(K_CONTEXT_BODY_OFFSET == __builtin_offsetof(Context, _body),
@@ -77,7 +82,7 @@ uint32_t Context::do_ipc(uint32_t stack, Descriptor d) {
     key(d.get_target()).deliver_from(this);
   } else if (d.get_receive_enabled()) {
     auto & k = key(d.get_source());
-    k.get()->deliver_to(k.get_brand(), this);
+    dispatch::deliver_to(*k.get(), k.get_brand(), this);
   }
   // Note that if neither bit is set, we'll just return with the registers
   // unchanged.
@@ -137,24 +142,170 @@ void Context::complete_blocked_receive(Exception e, uint32_t param) {
   complete_receive(e, param);
 }
 
+void Context::interrupt() {
+  switch (_body.state) {
+    case State::sending:
+      _body.sender_item.unlink();
+      on_blocked_delivery_aborted(Exception::would_block);
+      break;
+
+    case State::receiving:
+      // Invalidate any outstanding reply keys.
+      if (is_awaiting_reply()) advance_reply_brand();
+      _body.ctx_item.unlink();
+      complete_blocked_receive(Exception::would_block);
+      break;
+
+    case State::stopped:
+    case State::runnable:
+    case State::faulted:
+      break;
+  }
+}
+
+void Context::report_fault(uint32_t status, uint32_t address) {
+  PANIC_UNLESS(this == current, "fault in non-current Context");
+
+  _body.fault_status = status;
+  _body.fault_address = address;
+
+  _body.ctx_item.unlink();
+  _body.state = State::faulted;
+  pend_switch();
+
+  _body.supervisor.deliver_from(this);
+}
+
 void Context::apply_to_mpu() {
   using etl::armv7m::mpu;
 
   // Disable MPU to keep half-applied settings from kicking in.
   mpu.write_ctrl(mpu.read_ctrl().with_enable(false));
 
+  for (unsigned i = 0; i < config::n_task_regions; ++i) load_mpu_region(i);
+
+  // Re-enable MPU.
+  mpu.write_ctrl(mpu.read_ctrl().with_enable(true));
+}
+
+void Context::apply_to_mpu_for(Object const & object) {
+  using etl::armv7m::mpu;
+
+  // Find the affected regions first, so that the common case -- the object
+  // isn't mapped -- doesn't touch the MPU at all.
+  unsigned affected = 0;
   for (unsigned i = 0; i < config::n_task_regions; ++i) {
-    auto object = memory_region(i).get();
-    auto region =
-        object->get_region_for_brand(memory_region(i).get_brand());
-    mpu.write_rbar(region.rbar.with_valid(true).with_region(i));
-    mpu.write_rasr(region.rasr);
+    if (memory_region(i).designates(object)) affected |= 1u << i;
+  }
+  if (affected == 0) return;
+
+  mpu.write_ctrl(mpu.read_ctrl().with_enable(false));
+
+  for (unsigned i = 0; i < config::n_task_regions; ++i) {
+    if (affected & (1u << i)) load_mpu_region(i);
   }
 
-  // Re-enable MPU.
   mpu.write_ctrl(mpu.read_ctrl().with_enable(true));
 }
 
+void Context::load_mpu_region(unsigned i) {
+  using etl::armv7m::mpu;
+
+  auto object = memory_region(i).get();
+  auto region = dispatch::get_region_for_brand(
+      *object, memory_region(i).get_brand());
+  mpu.write_rbar(region.rbar.with_valid(true).with_region(i));
+  mpu.write_rasr(region.rasr);
+}
+
+bool Context::refill_region_cache(uint32_t address, uint32_t pc) {
+  using etl::armv7m::mpu;
+
+  if (!_body.region_cache_mask) return false;
+
+  auto keyring_obj = _body.region_keyring.get();
+  if (keyring_obj->get_kind() != Kind::keyring) return false;
+  auto keys = static_cast<Keyring *>(keyring_obj)->keys();
+
+  auto region_of = [](Key & k) {
+    return dispatch::get_region_for_brand(*k.get(), k.get_brand());
+  };
+
+  // Find a region key covering the address.  set_region_cache refuses larger
+  // Keyrings, but the search is clipped anyway to keep this bounded-time.
+  Key * found = nullptr;
+  for (unsigned i = 0;
+       i < keys.count() && i < config::max_region_cache_keys;
+       ++i) {
+    if (region_of(keys[i]).contains(address)) {
+      found = &keys[i];
+      break;
+    }
+  }
+  if (!found) return false;
+
+  // If that region is already loaded, the access was refused on its merits
+  // (e.g. a write through a read-only key), and loading it again would only
+  // fault again.  Meanwhile, note the regions holding the program's code and
+  // stack, which are clearly in use.
+  for (unsigned i = 0; i < config::n_task_regions; ++i) {
+    auto & k = memory_region(i);
+    if (k.designates(*found->get()) && k.get_brand() == found->get_brand()) {
+      return false;
+    }
+
+    auto region = region_of(k);
+    if (region.contains(pc) || region.contains(stack())) {
+      _body.region_clock.touch(i);
+    }
+  }
+
+  auto victim = _body.region_clock.choose(_body.region_cache_mask);
+  memory_region(victim) = *found;
+  _body.region_clock.touch(victim);
+
+  mpu.write_ctrl(mpu.read_ctrl().with_enable(false));
+  load_mpu_region(victim);
+  mpu.write_ctrl(mpu.read_ctrl().with_enable(true));
+
+  return true;
+}
+
+bool Context::write_restart_frame() {
+  auto frame = reinterpret_cast<StackRegisters *>(_body.restart.stack);
+
+  // The frame is written with this Context's authority, which means
+  // temporarily loading its memory map if it isn't current.
+  if (this != current) apply_to_mpu();
+
+  bool success = ustore(&frame->r0, 0)
+              && ustore(&frame->r1, 0)
+              && ustore(&frame->r2, 0)
+              && ustore(&frame->r3, 0)
+              && ustore(&frame->r12, 0)
+              && ustore(&frame->r14, 0)
+              && ustore(&frame->r15, _body.restart.pc)
+              && ustore(&frame->psr, 1 << 24);
+
+  if (this != current) current->apply_to_mpu();
+
+  return success;
+}
+
+void Context::restart() {
+  _body.ctx_item.unlink();
+  _body.sender_item.unlink();
+  advance_reply_brand();
+
+  for (unsigned i = 0; i < etl::array_count(_body.restart.r4_r11); ++i) {
+    _body.save.raw[i] = _body.restart.r4_r11[i];
+  }
+  _body.save.named.basepri = 0;
+  _body.save.named.stack = _body.restart.stack;
+
+  make_runnable();
+}
+
 void Context::make_runnable() {
   runnable.insert(&_body.ctx_item);
   _body.state = State::runnable;
@@ -171,6 +322,8 @@ Priority Context::get_priority() const {
 }
 
 Message Context::on_delivery(KeysRef k) {
+  if (ETL_UNLIKELY(_body.state == State::faulted)) return on_fault_delivery(k);
+
   // We're either synchronously delivering our message, or have been found on a
   // block list and asked to deliver.
 
@@ -196,16 +349,49 @@ Message Context::on_delivery(KeysRef k) {
                                 : key(d.get_source());
     // And this is where our outgoing message would be overwritten; thus the
     // copy above.
-    source.get()->deliver_to(source.get_brand(), this);
+    dispatch::deliver_to(*source.get(), source.get_brand(), this);
   }
 
   return m;
 }
 
+Message Context::on_fault_delivery(KeysRef k) {
+  // Describe the fault, including a reply key that can be used to resume us,
+  // and a service key for everything else.
+  k.set(0, make_reply_key());
+  k.set(1, make_key(0).ref());
+  for (unsigned ki = 2; ki < config::n_message_keys; ++ki) {
+    k.set(ki, Key::null());
+  }
+
+  // Remain faulted, but now awaiting a reply.
+  return {
+    Descriptor::zero().with_selector(selector::supervisor::fault),
+    _body.fault_status,
+    _body.fault_address,
+    _body.save.named.stack,
+  };
+}
+
+void Context::resume_after_fault(Sender * sender) {
+  // The content of the reply is not delivered, but an exception leaves us
+  // stopped.
+  Keys k;
+  auto m = sender->on_delivery(k);
+  if (m.desc.get_error()) return;
+
+  _body.sender_item.unlink();
+  make_runnable();
+}
+
 void Context::block_in_send(Brand const & brand, List<BlockingSender> & list) {
   PANIC_UNLESS(this == current, "non-current Context block_in_send");
 
-  if (get_descriptor().get_block()) {
+  if (_body.state == State::faulted) {
+    // Fault messages always block, and we've already left the run queue.
+    _body.saved_brand = brand;
+    list.insert(&_body.sender_item);
+  } else if (get_descriptor().get_block()) {
     _body.saved_brand = brand;
     list.insert(&_body.sender_item);
     _body.ctx_item.unlink();
@@ -219,17 +405,20 @@ void Context::block_in_send(Brand const & brand, List<BlockingSender> & list) {
 }
 
 ReceivedMessage Context::on_blocked_delivery(KeysRef k) {
-  make_runnable();
+  if (_body.state != State::faulted) make_runnable();
   return {
     .m = on_delivery(k),
     .brand = _body.saved_brand,
   };
 }
 
-void Context::on_blocked_delivery_aborted() {
+void Context::on_blocked_delivery_aborted(Exception e) {
+  // A fault message that can't be delivered leaves us stopped.
+  if (_body.state == State::faulted) return;
+
   make_runnable();
 
-  _body.save.sys = { Message::failure(Exception::would_block), 0 };
+  _body.save.sys = { Message::failure(e), 0 };
 }
 
 Key Context::make_reply_key() {
@@ -244,9 +433,38 @@ bool Context::is_reply_brand(Brand const & brand) {
   return (uint32_t(brand >> 32) & uint32_t(reply_brand_mask >> 32));
 }
 
+bool Context::is_live_reply_key(Key & key) {
+  if (!is_reply_brand(key.get_brand())) return false;
+
+  auto obj = key.get();
+  if (obj->get_kind() != Kind::context) return false;
+
+  // Reply keys are single-use, so only a key bearing the Context's current
+  // expected brand represents a caller still awaiting a reply.
+  auto ctx = static_cast<Context *>(obj);
+  return key.get_brand() == ctx->_body.expected_reply_brand;
+}
+
+unsigned Context::abandon_reply_keys() {
+  unsigned count = 0;
+  for (unsigned i = 0; i < config::n_task_keys; ++i) {
+    if (is_live_reply_key(key(i))) {
+      {
+        ScopedReplySender abandon{key(i),
+          Message::failure(Exception::abandoned)};
+      }
+      key(i) = Key::null();
+      ++count;
+    }
+  }
+  return count;
+}
+
 void Context::advance_reply_brand() {
+  // Wrap within the bits a Key can hold, so that reply keys can always be
+  // made.
   _body.expected_reply_brand =
-    (_body.expected_reply_brand + 1) | reply_brand_mask;
+    ((_body.expected_reply_brand + 1) & Key::brand_mask) | reply_brand_mask;
 }
 
 void Context::invalidation_hook() {
@@ -278,6 +496,11 @@ void Context::deliver_from(Brand const & brand, Sender * sender) {
     // Advance our expected brand, implicitly invalidating the current key.
     advance_reply_brand();
 
+    if (_body.state == State::faulted) {
+      resume_after_fault(sender);
+      return;
+    }
+
     // Unblocking from awaiting reply is supposed to advance the expected reply
     // brand, which should prevent us from reaching this point.
     PANIC_UNLESS(is_awaiting_reply(), "context not awaiting reply");
@@ -363,21 +586,21 @@ void Context::handle_protocol(Brand const &, Sender * sender) {
     case S::make_runnable:
       switch (_body.state) {
         case State::sending:
-          _body.sender_item.unlink();
-          on_blocked_delivery_aborted();
-          break;
-
         case State::receiving:
-          // Invalidate any outstanding reply keys.
-          if (is_awaiting_reply()) advance_reply_brand();
-          _body.ctx_item.unlink();
-          complete_blocked_receive(Exception::would_block);
+          interrupt();
           break;
 
         case State::stopped:
           make_runnable();
           break;
 
+        case State::faulted:
+          // Resume at the faulting instruction, abandoning the fault report.
+          _body.sender_item.unlink();
+          advance_reply_brand();
+          make_runnable();
+          break;
+
         case State::runnable:
           break;
       }
@@ -427,6 +650,116 @@ void Context::handle_protocol(Brand const &, Sender * sender) {
       }
       return;
 
+    case S::save_restart_state:
+      for (unsigned i = 0; i < etl::array_count(_body.restart.r4_r11); ++i) {
+        _body.restart.r4_r11[i] = _body.save.raw[i];
+      }
+      _body.restart.stack = _body.save.named.stack;
+      _body.restart.pc = m.d0;
+      return;
+
+    case S::set_supervisor:
+      _body.supervisor = k.keys[1];
+      return;
+
+    case S::set_region_cache:
+      {
+        auto mask = m.d0;
+        if (mask >= (1u << config::n_task_regions)) {
+          reply_sender.message() = Message::failure(Exception::bad_argument);
+          return;
+        }
+        if (mask && k.keys[1].get()->get_kind() != Kind::keyring) {
+          reply_sender.message() = Message::failure(Exception::bad_kind);
+          return;
+        }
+        if (mask && static_cast<Keyring *>(k.keys[1].get())->keys().count()
+                      > config::max_region_cache_keys) {
+          reply_sender.message() = Message::failure(Exception::bad_argument);
+          return;
+        }
+
+        _body.region_keyring = k.keys[1];
+        _body.region_cache_mask = uint8_t(mask);
+        _body.region_clock.reset();
+
+        // The cache starts out empty, and fills as the program faults.
+        for (unsigned i = 0; i < config::n_task_regions; ++i) {
+          if (mask & (1u << i)) memory_region(i) = Key::null();
+        }
+        if (current == this) apply_to_mpu();
+      }
+      return;
+
+    case S::restart:
+      // A Context can't restart itself: the reply to this call would go to a
+      // reply key that restarting has just revoked, leaving it blocked
+      // forever.
+      if (this == current) {
+        reply_sender.message() = Message::failure(Exception::bad_operation);
+        return;
+      }
+
+      // Rebuild the stack frame first, so that failure leaves this Context
+      // undisturbed.
+      if (!write_restart_frame()) {
+        reply_sender.message() = Message::failure(Exception::fault);
+        return;
+      }
+      restart();
+      return;
+
+    case S::enumerate_reply_keys:
+      {
+        auto start = m.d0;
+        if (start > config::n_task_keys) {
+          reply_sender.message() =
+            Message::failure(Exception::index_out_of_range);
+          return;
+        }
+
+        // Return up to one reply key per free message key slot, and where to
+        // pick up next time.
+        unsigned count = 0;
+        unsigned i = start;
+        for (; i < config::n_task_keys && count < config::n_message_keys - 1;
+             ++i) {
+          if (is_live_reply_key(key(i))) {
+            reply_sender.set_key(1 + count, key(i));
+            ++count;
+          }
+        }
+        reply_sender.message().d0 = count;
+        reply_sender.message().d1 = i;
+      }
+      return;
+
+    case S::abandon_reply_keys:
+      reply_sender.message().d0 = abandon_reply_keys();
+      return;
+
+    case S::destroy:
+      // A Context can't destroy itself, since the kernel is still running on
+      // its behalf.
+      if (this == current) {
+        reply_sender.message() = Message::failure(Exception::bad_operation);
+        return;
+      }
+
+      // Fail any callers first, since the reply keys they're waiting on are
+      // about to be discarded with the registers.  Check for the one way
+      // destruction can fail before doing so, so that a refusal leaves them
+      // undisturbed.
+      if (is_generation_near_wrap()) {
+        reply_sender.message() = Message::failure(Exception::causality);
+        return;
+      }
+      abandon_reply_keys();
+
+      destroy_object(*this, &_body, _body_size, reply_sender);
+      // Note: 'this' may no longer be a Context.
+      return;
+
     default:
       reply_sender.message() =
         Message::failure(Exception::bad_operation, m.desc.get_selector());
@@ -13,6 +13,8 @@
  * by a gate key.
  */
 
+#include <cstddef>
+
 #include "etl/armv7m/mpu.h"
 
 #include "common/abi_types.h"
@@ -24,6 +26,7 @@
 #include "k/maybe.h"
 #include "k/object.h"
 #include "k/region.h"
+#include "k/region_cache.h"
 #include "k/registers.h"
 #include "k/sender.h"
 
@@ -39,6 +42,9 @@ public:
     runnable,
     sending,
     receiving,
+    // Stopped by a fault.  The Context may be blocked delivering a fault
+    // message to its supervisor, or waiting for the supervisor's reply.
+    faulted,
   };
 
   struct Body {
@@ -65,9 +71,25 @@ public:
     Key memory_regions[config::n_task_regions]{};
 
     Brand expected_reply_brand{0};
+
+    // Snapshot taken by save_restart_state, used by restart.
+    RestartRegisters restart{};
+
+    // Description of the most recent fault, for delivery to the supervisor.
+    uint32_t fault_status{0};
+    uint32_t fault_address{0};
+
+    // Destination for fault messages.
+    Key supervisor{};
+
+    // Keyring of region keys used to refill the region cache, and the mask
+    // of region registers given over to it (see k/region_cache.h).
+    Key region_keyring{};
+    uint8_t region_cache_mask{0};
+    RegionClock region_clock{};
   };
 
-  Context(Generation g, Body &);
+  Context(Generation g, Body &, size_t body_size);
 
   /*************************************************************
    * Context-specific accessors for use inside the kernel.
@@ -94,6 +116,22 @@ public:
 
   void apply_to_mpu();
 
+  /*
+   * Reloads only the MPU regions whose keys designate 'object' (see
+   * Key::designates), for use when that object changes.  Does nothing -- and
+   * leaves the MPU enabled throughout -- if no region refers to it.
+   */
+  void apply_to_mpu_for(Object const & object);
+
+  /*
+   * Handles a memory management fault at 'address' in this Context, which
+   * must be current, by loading a region that covers it from the region
+   * keyring into the region cache.  'pc' is the faulting instruction's
+   * address.  Returns true if a region was loaded, so the instruction can be
+   * retried, or false if the fault should be reported.
+   */
+  bool refill_region_cache(uint32_t address, uint32_t pc);
+
   /*
    * Inserts this Context onto the runnable list and pends a context switch.
    * Mostly used as an internal implementation factor of state changes, this
@@ -137,6 +175,21 @@ public:
    */
   void complete_blocked_receive(Exception, uint32_t = 0);
 
+  /*
+   * Records a fault in this Context, which must be current, and stops it in
+   * faulted state.  A message describing the fault is sent to the supervisor
+   * key.  The supervisor can resume the Context by replying, or leave it
+   * stopped by replying with an exception.
+   */
+  void report_fault(uint32_t status, uint32_t address);
+
+  /*
+   * Cancels a blocked send or receive, including a wait for reply, causing
+   * the operation to fail with a would_block exception and making the Context
+   * runnable.  Has no effect on Contexts in other states.
+   */
+  void interrupt();
+
 
   /*************************************************************
    * Implementation of Sender.
@@ -160,7 +213,7 @@ public:
 
   Priority get_priority() const override;
   ReceivedMessage on_blocked_delivery(KeysRef) override;
-  void on_blocked_delivery_aborted() override;
+  void on_blocked_delivery_aborted(Exception) override;
 
 
   /*************************************************************
@@ -169,23 +222,36 @@ public:
 
   void deliver_from(Brand const &, Sender *) override;
   void deliver_to(Brand const &, Context *) override;
-  Kind get_kind() const override { return Kind::context; }
 
 private:
   Body & _body;
+  size_t _body_size;
 
   Descriptor get_descriptor() const { return _body.save.sys.m.desc; }
 
   Key make_reply_key();
   static bool is_reply_brand(Brand const &);
+  static bool is_live_reply_key(Key &);
 
   KeysRef get_receive_keys();
   KeysRef get_sent_keys();
 
+  Message on_fault_delivery(KeysRef);
+  void resume_after_fault(Sender *);
+
   void handle_protocol(Brand const &, Sender *);
+  bool write_restart_frame();
+  void restart();
   void block_in_reply();
   void advance_reply_brand();
 
+  // Fails each caller whose live reply key is in a Key Register with
+  // k.abandoned, nulling the key.  Returns the number of callers failed.
+  unsigned abandon_reply_keys();
+
+  // Loads task region 'index' into the MPU, which must be disabled.
+  void load_mpu_region(unsigned index);
+
   void invalidation_hook() override;
 };
 
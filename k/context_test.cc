@@ -0,0 +1,764 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "etl/armv7m/mpu.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/config.h"
+#include "k/context.h"
+#include "k/keyring.h"
+#include "k/list.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+namespace S = selector::context;
+
+// Where restart tests have the kernel rebuild the exception frame.  This is
+// static so that its address fits a register.
+static StackRegisters restart_frame;
+
+class ContextTest : public ::testing::Test {
+protected:
+  ObjectTable::Entry _entries[4];
+
+  // Wait queues for Contexts to block on.
+  List<BlockingSender> _senders;
+  List<Context> _receivers;
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  // The Context under test, standing in for a server holding reply keys...
+  Context::Body _server_body;
+  // ...and a Context standing in for one of its callers.
+  Context::Body _caller_body;
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  // Receives fault reports from the server.
+  Spy _supervisor{0, Object::Kind::context};
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Context{0, _server_body, sizeof(_server_body)};
+    new(&_entries[3]) Context{0, _caller_body, sizeof(_caller_body)};
+    // Pretend the caller has made a call before, so that there's an earlier
+    // reply brand to use for stale keys.
+    ++_caller_body.expected_reply_brand;
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    // Abandoning a caller or restarting the server makes it runnable; take
+    // them back off the run queue.
+    _caller_body.ctx_item.unlink();
+    _server_body.ctx_item.unlink();
+    _server_body.sender_item.unlink();
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  Context & server() {
+    return *static_cast<Context *>(&_entries[2].as_object());
+  }
+
+  Context & caller() {
+    return *static_cast<Context *>(&_entries[3].as_object());
+  }
+
+  // Puts the caller into the state of a Context blocked in call, awaiting a
+  // reply, and returns the matching reply key.
+  Key await_reply() {
+    _caller_body.state = Context::State::receiving;
+    return caller().make_key(_caller_body.expected_reply_brand).ref();
+  }
+
+  // A reply key from some earlier call, already used or abandoned.
+  Key stale_reply_key() {
+    return caller().make_key(_caller_body.expected_reply_brand - 1).ref();
+  }
+
+  Message const & send_from_spy(Message m) {
+    auto count = _spy.count();
+
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    server().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+
+  // Gives the server a restart snapshot, with its stack at 'frame'.
+  void prepare_restart(StackRegisters * frame) {
+    for (unsigned i = 0; i < 8; ++i) _server_body.restart.r4_r11[i] = 100 + i;
+    _server_body.restart.stack =
+      uint32_t(reinterpret_cast<uintptr_t>(frame));
+    _server_body.restart.pc = 0x08000101;
+  }
+
+  Message const & restart() {
+    return send_from_spy({Descriptor::call(S::restart, 0)});
+  }
+
+  // Faults the server while it's running.
+  void fault(uint32_t status, uint32_t address) {
+    server().make_runnable();
+    current = &server();
+    server().report_fault(status, address);
+    current = &_fake_context;
+  }
+
+  // Replies to the server's fault report.
+  void reply_to_fault(Message m) {
+    _sender.message() = m;
+    _supervisor.keys().keys[0].deliver_from(&_sender);
+  }
+
+  Message const & enumerate_reply_keys(unsigned start) {
+    return send_from_spy({Descriptor::call(S::enumerate_reply_keys, 0),
+                          start});
+  }
+
+  Message const & abandon_reply_keys() {
+    return send_from_spy({Descriptor::call(S::abandon_reply_keys, 0)});
+  }
+
+  Message const & destroy() {
+    return send_from_spy({Descriptor::call(S::destroy, 0)});
+  }
+};
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+#define ASSERT_REPLY_KEY(_index) \
+{ \
+  auto & __key = _spy.keys().keys[_index]; \
+  ASSERT_EQ(&caller(), __key.get()); \
+  ASSERT_EQ(_caller_body.expected_reply_brand, __key.get_brand()); \
+}
+
+#define ASSERT_NULL_KEY(_index) \
+  ASSERT_EQ(Object::Kind::null, _spy.keys().keys[_index].get()->get_kind())
+
+/*
+ * Save Restart State
+ */
+
+TEST_F(ContextTest, save_restart_state) {
+  for (unsigned i = 0; i < 8; ++i) _server_body.save.raw[i] = 10 + i;
+  _server_body.save.named.stack = 0x20001000;
+
+  auto & m = send_from_spy({Descriptor::call(S::save_restart_state, 0),
+                            0x08000201});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  for (unsigned i = 0; i < 8; ++i) {
+    ASSERT_EQ(10 + i, _server_body.restart.r4_r11[i]);
+  }
+  ASSERT_EQ(0x20001000, _server_body.restart.stack);
+  ASSERT_EQ(0x08000201, _server_body.restart.pc);
+}
+
+/*
+ * Restart
+ */
+
+TEST_F(ContextTest, restart_sending) {
+  prepare_restart(&restart_frame);
+  restart_frame = {1, 2, 3, 4, 12, 14, 15, 0};
+  for (unsigned i = 0; i < 8; ++i) _server_body.save.raw[i] = 0xBAD;
+  _server_body.save.named.basepri = 0x80;
+  _senders.insert(&_server_body.sender_item);
+  _server_body.state = Context::State::sending;
+  auto brand = _server_body.expected_reply_brand;
+
+  auto & m = restart();
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_FALSE(_server_body.sender_item.is_linked())
+    << "restart should leave the wait queue";
+  ASSERT_TRUE(_senders.is_empty());
+  ASSERT_EQ(Context::State::runnable, _server_body.state);
+  ASSERT_TRUE(_server_body.ctx_item.is_linked())
+    << "restart should join the run queue";
+  ASSERT_NE(brand, _server_body.expected_reply_brand)
+    << "outstanding reply keys should be revoked";
+
+  for (unsigned i = 0; i < 8; ++i) {
+    ASSERT_EQ(100 + i, _server_body.save.raw[i]);
+  }
+  ASSERT_EQ(0, _server_body.save.named.basepri);
+  ASSERT_EQ(_server_body.restart.stack, _server_body.save.named.stack);
+
+  ASSERT_EQ(0, restart_frame.r0);
+  ASSERT_EQ(0, restart_frame.r3);
+  ASSERT_EQ(0, restart_frame.r12);
+  ASSERT_EQ(0, restart_frame.r14);
+  ASSERT_EQ(0x08000101, restart_frame.r15);
+  ASSERT_EQ(1u << 24, restart_frame.psr);
+}
+
+TEST_F(ContextTest, restart_receiving) {
+  prepare_restart(&restart_frame);
+  server().block_in_receive(_receivers);
+
+  auto & m = restart();
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_TRUE(_receivers.is_empty())
+    << "restart should leave the wait queue";
+  ASSERT_EQ(Context::State::runnable, _server_body.state);
+}
+
+TEST_F(ContextTest, restart_bad_stack) {
+  // The fake treats low addresses as unmapped.
+  prepare_restart(nullptr);
+  for (unsigned i = 0; i < 8; ++i) _server_body.save.raw[i] = 0xBAD;
+  _senders.insert(&_server_body.sender_item);
+  _server_body.state = Context::State::sending;
+  auto brand = _server_body.expected_reply_brand;
+
+  ASSERT_RETURNED_EXCEPTION(restart(), Exception::fault);
+
+  ASSERT_TRUE(_server_body.sender_item.is_linked())
+    << "failed restart should leave the Context blocked";
+  ASSERT_EQ(Context::State::sending, _server_body.state);
+  ASSERT_EQ(brand, _server_body.expected_reply_brand);
+  for (unsigned i = 0; i < 8; ++i) {
+    ASSERT_EQ(0xBAD, _server_body.save.raw[i]);
+  }
+}
+
+TEST_F(ContextTest, restart_self) {
+  prepare_restart(&restart_frame);
+  current = &server();
+  auto brand = _server_body.expected_reply_brand;
+
+  ASSERT_RETURNED_EXCEPTION(restart(), Exception::bad_operation);
+
+  ASSERT_EQ(Context::State::stopped, _server_body.state);
+  ASSERT_EQ(brand, _server_body.expected_reply_brand);
+}
+
+/*
+ * Faults
+ */
+
+TEST_F(ContextTest, fault_reported) {
+  _server_body.supervisor = _supervisor.make_key(0).ref();
+  _server_body.save.named.stack = 0x20000F00;
+
+  fault(0x82, 0x20000004);
+
+  ASSERT_EQ(1, _supervisor.count()) << "fault should be reported once";
+  auto & m = _supervisor.message().m;
+  ASSERT_FALSE(m.desc.get_error());
+  ASSERT_EQ(selector::supervisor::fault, m.desc.get_selector());
+  ASSERT_EQ(0x82, m.d0) << "fault status";
+  ASSERT_EQ(0x20000004, m.d1) << "fault address";
+  ASSERT_EQ(0x20000F00, m.d2) << "stack";
+
+  auto & reply_key = _supervisor.keys().keys[0];
+  ASSERT_EQ(&server(), reply_key.get());
+  ASSERT_EQ(_server_body.expected_reply_brand, reply_key.get_brand());
+  auto & service_key = _supervisor.keys().keys[1];
+  ASSERT_EQ(&server(), service_key.get());
+  ASSERT_EQ(0, service_key.get_brand());
+
+  ASSERT_EQ(Context::State::faulted, _server_body.state);
+  ASSERT_FALSE(_server_body.ctx_item.is_linked())
+    << "faulted Context should leave the run queue";
+}
+
+TEST_F(ContextTest, fault_null_supervisor) {
+  fault(0x82, 0x20000004);
+
+  ASSERT_EQ(Context::State::faulted, _server_body.state);
+  ASSERT_FALSE(_server_body.ctx_item.is_linked());
+}
+
+TEST_F(ContextTest, fault_ignores_interrupt) {
+  _server_body.supervisor = _supervisor.make_key(0).ref();
+  fault(0x82, 0x20000004);
+  auto brand = _server_body.expected_reply_brand;
+
+  server().interrupt();
+
+  ASSERT_EQ(Context::State::faulted, _server_body.state);
+  ASSERT_FALSE(_server_body.ctx_item.is_linked());
+  ASSERT_EQ(brand, _server_body.expected_reply_brand)
+    << "supervisor's reply key should still work";
+}
+
+TEST_F(ContextTest, fault_resume) {
+  _server_body.supervisor = _supervisor.make_key(0).ref();
+  fault(0x82, 0x20000004);
+
+  reply_to_fault({Descriptor::zero()});
+
+  ASSERT_EQ(Context::State::runnable, _server_body.state);
+  ASSERT_TRUE(_server_body.ctx_item.is_linked());
+}
+
+TEST_F(ContextTest, fault_refuse) {
+  _server_body.supervisor = _supervisor.make_key(0).ref();
+  fault(0x82, 0x20000004);
+
+  reply_to_fault(Message::failure(Exception::fault));
+
+  ASSERT_EQ(Context::State::faulted, _server_body.state);
+  ASSERT_FALSE(_server_body.ctx_item.is_linked());
+}
+
+TEST_F(ContextTest, fault_restart) {
+  _server_body.supervisor = _supervisor.make_key(0).ref();
+  fault(0x82, 0x20000004);
+  prepare_restart(&restart_frame);
+
+  ASSERT_MESSAGE_SUCCESS(restart());
+
+  ASSERT_EQ(Context::State::runnable, _server_body.state);
+  ASSERT_TRUE(_server_body.ctx_item.is_linked());
+  ASSERT_NE(_server_body.expected_reply_brand,
+            _supervisor.keys().keys[0].get_brand())
+    << "restart should revoke the supervisor's reply key";
+}
+
+/*
+ * Enumerate Reply Keys
+ */
+
+TEST_F(ContextTest, enumerate_none) {
+  auto & m = enumerate_reply_keys(0);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0, m.d0);
+  ASSERT_EQ(config::n_task_keys, m.d1);
+  ASSERT_NULL_KEY(1);
+}
+
+TEST_F(ContextTest, enumerate_skips_stale) {
+  server().key(2) = stale_reply_key();
+  server().key(5) = await_reply();
+  server().key(6) = _spy.make_key(0).ref();  // not a reply key at all
+
+  auto & m = enumerate_reply_keys(0);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0);
+  ASSERT_EQ(config::n_task_keys, m.d1);
+  ASSERT_REPLY_KEY(1);
+  ASSERT_NULL_KEY(2);
+}
+
+TEST_F(ContextTest, enumerate_pages) {
+  // Fill more registers than fit in one reply.  Only one caller exists, but
+  // copies of its reply key are all equally live.
+  auto k = await_reply();
+  for (unsigned i = 1; i <= config::n_message_keys; ++i) server().key(i) = k;
+
+  auto & m = enumerate_reply_keys(0);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(config::n_message_keys - 1, m.d0);
+  ASSERT_EQ(config::n_message_keys, m.d1)
+    << "scan should stop after the last key it returned";
+  for (unsigned i = 1; i < config::n_message_keys; ++i) ASSERT_REPLY_KEY(i);
+
+  auto & m2 = enumerate_reply_keys(m.d1);
+  ASSERT_MESSAGE_SUCCESS(m2);
+  ASSERT_EQ(1, m2.d0);
+  ASSERT_EQ(config::n_task_keys, m2.d1);
+  ASSERT_REPLY_KEY(1);
+  ASSERT_NULL_KEY(2);
+}
+
+TEST_F(ContextTest, enumerate_at_end) {
+  auto & m = enumerate_reply_keys(config::n_task_keys);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0, m.d0);
+  ASSERT_EQ(config::n_task_keys, m.d1);
+}
+
+TEST_F(ContextTest, enumerate_out_of_range) {
+  auto & m = enumerate_reply_keys(config::n_task_keys + 1);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::index_out_of_range);
+}
+
+/*
+ * Abandon Reply Keys
+ */
+
+TEST_F(ContextTest, abandon_none) {
+  server().key(2) = stale_reply_key();
+
+  auto & m = abandon_reply_keys();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0, m.d0);
+  ASSERT_EQ(&caller(), server().key(2).get())
+    << "stale reply keys should be left alone";
+}
+
+TEST_F(ContextTest, abandon_live) {
+  auto brand = _caller_body.expected_reply_brand;
+  server().key(3) = await_reply();
+  server().key(4) = stale_reply_key();
+
+  auto & m = abandon_reply_keys();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0);
+
+  ASSERT_EQ(Object::Kind::null, server().key(3).get()->get_kind())
+    << "abandoned reply key should be nulled";
+  ASSERT_EQ(&caller(), server().key(4).get());
+
+  // The caller should have been failed, as though by a reply.
+  ASSERT_EQ(Context::State::runnable, _caller_body.state);
+  auto & r = _caller_body.save.sys;
+  ASSERT_EQ(brand, r.brand);
+  ASSERT_RETURNED_EXCEPTION(r.m, Exception::abandoned);
+  ASSERT_NE(brand, _caller_body.expected_reply_brand)
+    << "caller's reply keys should have been revoked";
+}
+
+TEST_F(ContextTest, abandon_copies_once) {
+  // Once the first copy is used, the rest are stale.
+  auto k = await_reply();
+  server().key(1) = k;
+  server().key(2) = k;
+
+  auto & m = abandon_reply_keys();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0);
+  ASSERT_EQ(Object::Kind::null, server().key(1).get()->get_kind());
+}
+
+/*
+ * Destroy
+ */
+
+TEST_F(ContextTest, destroy_sending) {
+  _senders.insert(&_server_body.sender_item);
+  _server_body.state = Context::State::sending;
+
+  auto & m = destroy();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_TRUE(_senders.is_empty())
+    << "a destroyed Context must leave the Gate's senders";
+  ASSERT_EQ(Object::Kind::memory, _entries[2].as_object().get_kind());
+}
+
+TEST_F(ContextTest, destroy_receiving) {
+  server().block_in_receive(_receivers);
+
+  auto & m = destroy();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_TRUE(_receivers.is_empty())
+    << "a destroyed Context must leave the Gate's receivers";
+  ASSERT_EQ(Object::Kind::memory, _entries[2].as_object().get_kind());
+}
+
+TEST_F(ContextTest, destroy_abandons_callers) {
+  auto brand = _caller_body.expected_reply_brand;
+  server().key(5) = await_reply();
+
+  auto & m = destroy();
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Context::State::runnable, _caller_body.state)
+    << "callers must not be left waiting on a destroyed server";
+  auto & r = _caller_body.save.sys;
+  ASSERT_EQ(brand, r.brand);
+  ASSERT_RETURNED_EXCEPTION(r.m, Exception::abandoned);
+}
+
+TEST_F(ContextTest, destroy_self) {
+  server().key(5) = await_reply();
+  current = &server();
+
+  auto & m = destroy();
+  current = &_fake_context;
+
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_EQ(Object::Kind::context, _entries[2].as_object().get_kind());
+  ASSERT_EQ(Context::State::receiving, _caller_body.state)
+    << "a refused destroy must leave callers waiting";
+}
+
+/*******************************************************************************
+ * Region cache.
+ */
+
+static constexpr uint32_t mpu_poison = 0xDEADBEE0;
+
+static void poison_mpu() {
+  etl::armv7m::mpu.write_rbar(Region::Rbar(mpu_poison));
+  etl::armv7m::mpu.write_rasr(Region::Rasr(mpu_poison));
+}
+
+class ContextTest_RegionCache : public ::testing::Test {
+protected:
+  static constexpr unsigned ring_size = 4;
+
+  // Memory objects at 'memory_base', 'memory_base + memory_size', and so on.
+  static constexpr uintptr_t memory_base = 0x20000000;
+  static constexpr size_t memory_size = 0x1000;
+  static constexpr unsigned memory_count = 3;
+
+  static constexpr Region::Rasr rw_rasr =
+    Region::Rasr().with_ap(etl::armv7m::Mpu::AccessPermissions::p_write_u_write);
+
+  ObjectTable::Entry _entries[5 + memory_count];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  Context::Body _uut_body;
+
+  Key _ring[ring_size]{};
+  Key _big_ring[config::max_region_cache_keys + 1]{};
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Context{0, _uut_body, sizeof(_uut_body)};
+    new(&_entries[3]) Keyring{0, {_ring, ring_size}, sizeof(_ring)};
+    for (unsigned i = 0; i < memory_count; ++i) {
+      new(&_entries[4 + i]) Memory{0, memory_base + i * memory_size,
+                                   memory_size, 0};
+    }
+    new(&_entries[4 + memory_count]) Keyring{
+      0, {_big_ring, config::max_region_cache_keys + 1}, sizeof(_big_ring)};
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  Context & uut() {
+    return *static_cast<Context *>(&_entries[2].as_object());
+  }
+
+  Object & keyring() {
+    return _entries[3].as_object();
+  }
+
+  // A Keyring too big to serve as a region cache.
+  Object & big_keyring() {
+    return _entries[4 + memory_count].as_object();
+  }
+
+  Memory & memory(unsigned i) {
+    return *static_cast<Memory *>(&_entries[4 + i].as_object());
+  }
+
+  Key region_key(unsigned i) {
+    return memory(i).make_key(uint32_t(rw_rasr) >> 8).ref();
+  }
+
+  static uint32_t address_in(unsigned i) {
+    return uint32_t(memory_base + i * memory_size + 0x10);
+  }
+
+  Message const & set_region_cache(unsigned mask, Object & ring) {
+    auto count = _spy.count();
+
+    _sender.message() = {Descriptor::call(S::set_region_cache, 0), mask};
+    _sender.set_key(0, _spy.make_key(0).ref());
+    _sender.set_key(1, ring.make_key(0).ref());
+    uut().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+
+  bool refill(unsigned i) {
+    return uut().refill_region_cache(address_in(i), 0);
+  }
+
+  // Checks whether region register 'r' holds the key to Memory 'i'.
+  bool holds(unsigned r, unsigned i) {
+    return uut().memory_region(r).get() == &memory(i);
+  }
+};
+
+constexpr Region::Rasr ContextTest_RegionCache::rw_rasr;
+
+TEST_F(ContextTest_RegionCache, refill_loads_covering_key) {
+  _ring[0] = region_key(0);
+  _ring[1] = region_key(1);
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b011000, keyring()));
+  uut().memory_region(0) = region_key(2);
+  poison_mpu();
+
+  ASSERT_TRUE(refill(1));
+
+  unsigned loaded = 0;
+  for (unsigned r = 0; r < config::n_task_regions; ++r) {
+    if (holds(r, 1)) loaded |= 1u << r;
+  }
+  ASSERT_TRUE(loaded == 0b001000 || loaded == 0b010000)
+    << "covering key should be loaded into one register in the mask";
+  ASSERT_TRUE(holds(0, 2));
+
+  auto rbar = etl::armv7m::mpu.read_rbar();
+  ASSERT_TRUE(rbar.get_valid());
+  ASSERT_EQ(loaded, 1u << rbar.get_region())
+    << "the refilled register should have been loaded into the MPU";
+  ASSERT_TRUE(etl::armv7m::mpu.read_rasr().get_enable());
+  ASSERT_TRUE(etl::armv7m::mpu.read_ctrl().get_enable());
+}
+
+TEST_F(ContextTest_RegionCache, refill_stays_in_mask) {
+  _ring[0] = region_key(0);
+  _ring[1] = region_key(1);
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b000100, keyring()));
+  for (unsigned r = 0; r < config::n_task_regions; ++r) {
+    if (r != 2) uut().memory_region(r) = region_key(2);
+  }
+
+  for (unsigned n = 0; n < 4; ++n) {
+    auto i = n % 2;
+    ASSERT_TRUE(refill(i));
+    ASSERT_TRUE(holds(2, i)) << "the only register in the mask is the victim";
+    for (unsigned r = 0; r < config::n_task_regions; ++r) {
+      if (r == 2) continue;
+      ASSERT_TRUE(holds(r, 2)) << "register " << r << " evicted";
+    }
+  }
+}
+
+TEST_F(ContextTest_RegionCache, refill_already_loaded) {
+  _ring[0] = region_key(0);
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b000110, keyring()));
+
+  ASSERT_TRUE(refill(0));
+  poison_mpu();
+
+  ASSERT_FALSE(refill(0))
+    << "a fault within a loaded region is a permission fault";
+  ASSERT_EQ(mpu_poison, uint32_t(etl::armv7m::mpu.read_rbar()))
+    << "a refused refill should not touch the MPU";
+  ASSERT_FALSE(holds(1, 0) && holds(2, 0))
+    << "the key should not have been loaded twice";
+}
+
+TEST_F(ContextTest_RegionCache, refill_uncovered) {
+  _ring[0] = region_key(0);
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b000110, keyring()));
+
+  ASSERT_FALSE(refill(1));
+}
+
+TEST_F(ContextTest_RegionCache, refill_disabled) {
+  _ring[0] = region_key(0);
+
+  ASSERT_FALSE(refill(0)) << "a Context has no region cache by default";
+}
+
+TEST_F(ContextTest_RegionCache, refill_skips_junk) {
+  _ring[0] = keyring().make_key(0).ref();
+  _ring[1] = region_key(0);
+  _ring[2] = region_key(1);
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b000001, keyring()));
+  memory(0).invalidate();
+
+  ASSERT_FALSE(refill(0)) << "stale region keys should not be loaded";
+  ASSERT_TRUE(refill(1));
+  ASSERT_TRUE(holds(0, 1));
+}
+
+TEST_F(ContextTest_RegionCache, set_too_big) {
+  _big_ring[0] = region_key(0);
+
+  auto & m = set_region_cache(0b000001, big_keyring());
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+  ASSERT_FALSE(refill(0)) << "the region cache should remain disabled";
+}
+
+TEST_F(ContextTest_RegionCache, set_clears_masked_registers) {
+  for (unsigned r = 0; r < config::n_task_regions; ++r) {
+    uut().memory_region(r) = region_key(2);
+  }
+  poison_mpu();
+
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b000110, keyring()));
+
+  for (unsigned r = 0; r < config::n_task_regions; ++r) {
+    if (r == 1 || r == 2) {
+      ASSERT_EQ(Object::Kind::null, uut().memory_region(r).get()->get_kind())
+        << "register " << r << " should start out empty";
+    } else {
+      ASSERT_TRUE(holds(r, 2)) << "register " << r << " is outside the mask";
+    }
+  }
+  ASSERT_EQ(mpu_poison, uint32_t(etl::armv7m::mpu.read_rbar()))
+    << "the MPU belongs to the current Context, which is another one";
+}
+
+TEST_F(ContextTest_RegionCache, set_reloads_current) {
+  for (unsigned r = 0; r < config::n_task_regions; ++r) {
+    uut().memory_region(r) = region_key(2);
+  }
+  current = &uut();
+  poison_mpu();
+
+  ASSERT_MESSAGE_SUCCESS(set_region_cache(0b100000, keyring()));
+
+  auto rbar = etl::armv7m::mpu.read_rbar();
+  ASSERT_TRUE(rbar.get_valid());
+  ASSERT_EQ(5, rbar.get_region());
+  ASSERT_FALSE(etl::armv7m::mpu.read_rasr().get_enable())
+    << "the emptied register should have been reloaded as disabled";
+  ASSERT_TRUE(etl::armv7m::mpu.read_ctrl().get_enable());
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
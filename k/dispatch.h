@@ -0,0 +1,129 @@
+#ifndef K_DISPATCH_H
+#define K_DISPATCH_H
+
+/*
+ * Dispatch of the Object operations used on IPC hot paths.
+ *
+ * By default these are plain virtual calls.  Defining KERNEL_KIND_DISPATCH
+ * instead switches on the Object's Kind -- which is stored in its head and
+ * dense, so the switch compiles to a single indexed branch -- and calls the
+ * concrete subclass's implementation directly.  Because the calls are no
+ * longer virtual, the compiler is free to inline the common cases (Gate and
+ * Context IPC, replies) into the caller, particularly under LTO.
+ *
+ * The cost is that this file must know about every Object subclass, and that
+ * Objects must be what they claim to be: an Object reporting Kind::context
+ * will be treated as a Context, without consulting its vtable.  Test doubles
+ * that impersonate other kinds (k/testutil/spy.h) are therefore only usable
+ * with virtual dispatch; k/dispatch_test.cc uses real objects, and is built
+ * both ways.
+ */
+
+#include "common/abi_types.h"
+
+#include "k/object.h"
+#include "k/region.h"
+
+#ifdef KERNEL_KIND_DISPATCH
+  #include "k/context.h"
+  #include "k/gate.h"
+  #include "k/interrupt.h"
+  #include "k/keyring.h"
+  #include "k/memory.h"
+  #include "k/null_object.h"
+  #include "k/object_table.h"
+  #include "k/panic.h"
+  #include "k/slot.h"
+  #include "k/timer.h"
+#endif
+
+namespace k {
+
+struct Context;  // see: k/context.h
+struct Sender;   // see: k/sender.h
+
+namespace dispatch {
+
+#ifdef KERNEL_KIND_DISPATCH
+
+/*
+ * Applies 'f' to 'o', after casting 'o' to the subclass indicated by its Kind.
+ */
+template <typename F>
+inline auto visit(Object & o, F const & f)
+    -> decltype(f(static_cast<NullObject &>(o))) {
+  using K = Object::Kind;
+  switch (o.get_kind()) {
+    case K::null:         return f(static_cast<NullObject &>(o));
+    case K::object_table: return f(static_cast<ObjectTable &>(o));
+    case K::slot:         return f(static_cast<Slot &>(o));
+    case K::memory:       return f(static_cast<Memory &>(o));
+    case K::context:      return f(static_cast<Context &>(o));
+    case K::gate:         return f(static_cast<Gate &>(o));
+    case K::interrupt:    return f(static_cast<Interrupt &>(o));
+    case K::timer:        return f(static_cast<Timer &>(o));
+    case K::keyring:      return f(static_cast<Keyring &>(o));
+  }
+  PANIC("bad object kind");
+}
+
+/*
+ * Each of these calls the named member function as implemented (or inherited)
+ * by the concrete type T.  The qualified name suppresses virtual dispatch.
+ */
+
+struct DeliverFrom {
+  Brand const & brand;
+  Sender * sender;
+
+  template <typename T>
+  void operator()(T & o) const { o.T::deliver_from(brand, sender); }
+};
+
+struct DeliverTo {
+  Brand const & brand;
+  Context * ctx;
+
+  template <typename T>
+  void operator()(T & o) const { o.T::deliver_to(brand, ctx); }
+};
+
+struct GetRegionForBrand {
+  Brand const & brand;
+
+  template <typename T>
+  Region operator()(T & o) const { return o.T::get_region_for_brand(brand); }
+};
+
+inline void deliver_from(Object & o, Brand const & brand, Sender * sender) {
+  visit(o, DeliverFrom{brand, sender});
+}
+
+inline void deliver_to(Object & o, Brand const & brand, Context * ctx) {
+  visit(o, DeliverTo{brand, ctx});
+}
+
+inline Region get_region_for_brand(Object & o, Brand const & brand) {
+  return visit(o, GetRegionForBrand{brand});
+}
+
+#else  // !defined(KERNEL_KIND_DISPATCH)
+
+inline void deliver_from(Object & o, Brand const & brand, Sender * sender) {
+  o.deliver_from(brand, sender);
+}
+
+inline void deliver_to(Object & o, Brand const & brand, Context * ctx) {
+  o.deliver_to(brand, ctx);
+}
+
+inline Region get_region_for_brand(Object & o, Brand const & brand) {
+  return o.get_region_for_brand(brand);
+}
+
+#endif  // KERNEL_KIND_DISPATCH
+
+}  // namespace dispatch
+}  // namespace k
+
+#endif  // K_DISPATCH_H
@@ -0,0 +1,106 @@
+/*
+ * Host microbenchmark for Object dispatch (see k/dispatch.h).
+ *
+ * This is built twice, once using virtual dispatch and once with
+ * KERNEL_KIND_DISPATCH, so the two can be compared by running both.  It
+ * measures:
+ *
+ * - call: a non-blocking call to a Gate's kernel protocol, whose reply is
+ *   delivered through a second key.  This exercises Key::deliver_from and
+ *   ScopedReplySender, the paths taken by every IPC.
+ *
+ * - apply_to_mpu: loading a Context's memory regions, which looks up the
+ *   Region for each region key.
+ *
+ * Host numbers only roughly predict the target, but the relative cost of the
+ * two dispatch strategies is what we're after.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+#include "common/selectors.h"
+
+#include "k/context.h"
+#include "k/gate.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+
+namespace k {
+
+static constexpr unsigned iterations = 10 * 1000 * 1000;
+
+static ObjectTable::Entry entries[5];
+static Gate::Body gate_body;
+static Context::Body context_body;
+
+static ObjectTable & table() {
+  return *static_cast<ObjectTable *>(&entries[1].as_object());
+}
+
+static void set_up() {
+  new (&entries[0]) NullObject{0};
+
+  {
+    auto o = new(&entries[1]) ObjectTable{0};
+    set_object_table(o);
+    o->set_entries(entries);
+  }
+
+  new(&entries[2]) Gate{0, gate_body, sizeof(gate_body)};
+  new(&entries[3]) Memory{0, 0x20000000, 1024, 0};
+  new(&entries[4]) Context{0, context_body, sizeof(context_body)};
+}
+
+template <typename F>
+static void measure(char const * name, F && f) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; ++i) f();
+  auto end = std::chrono::steady_clock::now();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+  std::printf("%-14s %8.2f ns/op\n", name, double(ns.count()) / iterations);
+}
+
+static void bench_call() {
+  auto gate_key = entries[2].as_object().make_key(0).ref();
+
+  // The reply goes to the Object Table, which will refuse it with a reply of
+  // its own -- to the null key, which is elided.  That's one extra dispatch,
+  // which is fine: replies are dispatched too.
+  ReplySender sender{{Descriptor::call(selector::gate::make_client_key, 0)}};
+  sender.set_key(0, table().make_key(0).ref());
+
+  measure("call", [&] { gate_key.deliver_from(&sender); });
+}
+
+static void bench_apply_to_mpu() {
+  auto & ctx = *static_cast<Context *>(&entries[4].as_object());
+  auto mem_key = entries[3].as_object().make_key(0).ref();
+
+  // Mix memory keys with null keys, as a typical program would.
+  for (unsigned i = 0; i < config::n_task_regions; i += 2) {
+    ctx.memory_region(i) = mem_key;
+  }
+
+  measure("apply_to_mpu", [&] { ctx.apply_to_mpu(); });
+}
+
+}  // namespace k
+
+int main() {
+#ifdef KERNEL_KIND_DISPATCH
+  std::printf("dispatch: kind\n");
+#else
+  std::printf("dispatch: virtual\n");
+#endif
+
+  k::set_up();
+  k::bench_call();
+  k::bench_apply_to_mpu();
+  k::reset_object_table_for_test();
+  return 0;
+}
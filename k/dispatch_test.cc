@@ -0,0 +1,248 @@
+/*
+ * Tests of Object dispatch (see k/dispatch.h) through keys to real objects.
+ *
+ * This is built twice, once using virtual dispatch and once with
+ * KERNEL_KIND_DISPATCH.  Test doubles like k/testutil/spy.h only work with
+ * virtual dispatch, so replies here go to a real Context, which stands in for
+ * a program that has called some key and is awaiting the reply.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "etl/armv7m/mpu.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/context.h"
+#include "k/dispatch.h"
+#include "k/gate.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+
+namespace k {
+
+static constexpr Brand transparent_mask = Brand(1) << 63;
+
+class DispatchTest : public ::testing::Test {
+protected:
+  static constexpr uintptr_t memory_base = 0x20000000;
+  static constexpr size_t memory_size = 1024;
+
+  static constexpr Region::Rasr rw_rasr =
+    Region::Rasr().with_ap(etl::armv7m::Mpu::AccessPermissions::p_write_u_write);
+
+  ObjectTable::Entry _entries[6];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  Gate::Body _gate_body;
+  // The caller of each operation, which receives its reply...
+  Context::Body _client_body;
+  // ...and a Context to receive from the Gate.
+  Context::Body _server_body;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Gate{0, _gate_body, sizeof(_gate_body)};
+    new(&_entries[3]) Memory{0, memory_base, memory_size, 0};
+    new(&_entries[4]) Context{0, _client_body, sizeof(_client_body)};
+    new(&_entries[5]) Context{0, _server_body, sizeof(_server_body)};
+
+    // Received keys land in registers 1 through 4.
+    _client_body.save.named.r11 = 0x4321;
+    _server_body.save.named.r11 = 0x4321;
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    _client_body.ctx_item.unlink();
+    _server_body.ctx_item.unlink();
+    _client_body.sender_item.unlink();
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  Gate & gate() {
+    return *static_cast<Gate *>(&_entries[2].as_object());
+  }
+
+  Memory & memory() {
+    return *static_cast<Memory *>(&_entries[3].as_object());
+  }
+
+  Context & client() {
+    return *static_cast<Context *>(&_entries[4].as_object());
+  }
+
+  Context & server() {
+    return *static_cast<Context *>(&_entries[5].as_object());
+  }
+
+  // Puts the client into the state of a Context blocked in call, and returns
+  // the matching reply key.
+  Key await_reply() {
+    _client_body.state = Context::State::receiving;
+    return client().make_key(_client_body.expected_reply_brand).ref();
+  }
+
+  // Sends 'm' through 'target' as a call from the client, and returns the
+  // reply.
+  Message const & call(Key target, Message m) {
+    ReplySender sender{m};
+    sender.set_key(0, await_reply());
+    target.deliver_from(&sender);
+
+    EXPECT_EQ(Context::State::runnable, _client_body.state)
+      << "the client should have been replied to";
+    return _client_body.save.sys.m;
+  }
+};
+
+constexpr uintptr_t DispatchTest::memory_base;
+constexpr size_t DispatchTest::memory_size;
+constexpr Region::Rasr DispatchTest::rw_rasr;
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+/*
+ * Gate
+ */
+
+TEST_F(DispatchTest, gate_protocol) {
+  auto & m = call(gate().make_key(0).ref(),
+                  {Descriptor::call(selector::gate::make_client_key, 0), 5});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  // Reply key 1 arrives in register 2.
+  ASSERT_EQ(&gate(), client().key(2).get());
+  ASSERT_EQ(5 | transparent_mask, client().key(2).get_brand());
+}
+
+TEST_F(DispatchTest, gate_transfer) {
+  dispatch::deliver_to(gate(), 0, &server());
+  ASSERT_EQ(Context::State::receiving, _server_body.state);
+
+  auto client_key = gate().make_key(5 | transparent_mask).ref();
+  ReplySender sender{{Descriptor::zero(), 42}};
+  sender.set_key(1, memory().make_key(0).ref());
+  client_key.deliver_from(&sender);
+
+  ASSERT_EQ(Context::State::runnable, _server_body.state);
+  ASSERT_EQ(42, _server_body.save.sys.m.d0);
+  ASSERT_EQ(5 | transparent_mask, _server_body.save.sys.brand);
+  ASSERT_EQ(&memory(), server().key(2).get());
+}
+
+TEST_F(DispatchTest, gate_refuses_receive_through_client_key) {
+  dispatch::deliver_to(gate(), 5 | transparent_mask, &server());
+
+  ASSERT_RETURNED_EXCEPTION(_server_body.save.sys.m, Exception::bad_operation);
+  ASSERT_TRUE(_gate_body.receivers.is_empty());
+}
+
+/*
+ * Context
+ */
+
+TEST_F(DispatchTest, context_reply) {
+  auto reply_key = await_reply();
+  ReplySender sender{{Descriptor::zero(), 7}};
+  sender.set_key(1, gate().make_key(0).ref());
+  reply_key.deliver_from(&sender);
+
+  ASSERT_EQ(Context::State::runnable, _client_body.state);
+  ASSERT_EQ(7, _client_body.save.sys.m.d0);
+  ASSERT_EQ(reply_key.get_brand(), _client_body.save.sys.brand);
+  ASSERT_EQ(&gate(), client().key(2).get());
+}
+
+TEST_F(DispatchTest, context_stale_reply) {
+  auto reply_key = await_reply();
+  ReplySender sender{{Descriptor::zero(), 7}};
+  reply_key.deliver_from(&sender);
+  _client_body.state = Context::State::receiving;
+  _client_body.ctx_item.unlink();
+
+  reply_key.deliver_from(&sender);
+  ASSERT_EQ(Context::State::receiving, _client_body.state)
+    << "a used reply key must not wake the client";
+}
+
+TEST_F(DispatchTest, context_protocol) {
+  _server_body.save.named.r8 = 0x1234;
+
+  auto & m = call(server().make_key(0).ref(),
+                  {Descriptor::call(selector::context::read_register, 0), 4});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0x1234, m.d0);
+}
+
+/*
+ * Memory
+ */
+
+TEST_F(DispatchTest, memory_protocol) {
+  auto & m = call(memory().make_key(uint32_t(rw_rasr) >> 8).ref(),
+                  {Descriptor::call(selector::memory::inspect, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(memory_base, m.d0);
+  ASSERT_EQ(memory_size, m.d2);
+}
+
+TEST_F(DispatchTest, memory_region) {
+  auto region = dispatch::get_region_for_brand(memory(),
+                                               uint32_t(rw_rasr) >> 8);
+  ASSERT_TRUE(region.rasr.get_enable());
+  ASSERT_TRUE(region.contains(memory_base));
+  ASSERT_FALSE(region.contains(memory_base + memory_size));
+
+  ASSERT_FALSE(dispatch::get_region_for_brand(gate(), 0).rasr.get_enable())
+    << "only Memory confers authority in a region register";
+}
+
+/*
+ * Null
+ */
+
+TEST_F(DispatchTest, null) {
+  auto & m = call(Key::null(), {Descriptor::call(1, 0)});
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+}
+
+TEST_F(DispatchTest, null_receive) {
+  dispatch::deliver_to(_entries[0].as_object(), 0, &server());
+  ASSERT_RETURNED_EXCEPTION(_server_body.save.sys.m, Exception::bad_operation);
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 #include "common/exceptions.h"
 #include "common/selectors.h"
 
+#include "k/become.h"
 #include "k/context.h"
 #include "k/keys.h"
 #include "k/reply_sender.h"
@@ -32,8 +33,20 @@ void Gate::deliver_from(Brand const & brand, Sender * sender) {
   namespace S = selector::gate;
   switch (m.desc.get_selector()) {
     case S::make_client_key:
-      reply_sender.set_key(1,
-          make_key(m.d0 | (Brand(m.d1) << 32) | transparent_mask).ref());
+      if (auto maybe_key =
+            make_key(m.d0 | (Brand(m.d1) << 32) | transparent_mask)) {
+        reply_sender.set_key(1, maybe_key.ref());
+      } else {
+        reply_sender.message() = Message::failure(Exception::bad_brand);
+      }
+      return;
+
+    case S::discharge_one:
+      do_discharge_one(reply_sender);
+      return;
+
+    case S::destroy:
+      do_destroy(reply_sender);
       return;
 
     default:
@@ -43,6 +56,32 @@ void Gate::deliver_from(Brand const & brand, Sender * sender) {
   }
 }
 
+void Gate::do_discharge_one(ScopedReplySender & reply_sender) {
+  // At most one of the lists is non-empty at any time, since a sender or
+  // receiver only blocks when there's no partner waiting.
+  if (auto s = _body.senders.take()) {
+    s.ref()->on_blocked_delivery_aborted(Exception::abandoned);
+    reply_sender.message().d0 = 1;
+  } else if (auto r = _body.receivers.take()) {
+    r.ref()->complete_blocked_receive(Exception::abandoned);
+    reply_sender.message().d0 = 2;
+  } else {
+    reply_sender.message().d0 = 0;
+  }
+}
+
+void Gate::do_destroy(ScopedReplySender & reply_sender) {
+  // Refuse to destroy a Gate with waiters, rather than walking the lists;
+  // callers can discharge them one at a time first.
+  if (!_body.senders.is_empty() || !_body.receivers.is_empty()) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  destroy_object(*this, &_body, _body_size, reply_sender);
+  // Note: 'this' may no longer be a Gate.
+}
+
 void Gate::deliver_to(Brand const & brand, Context * receiver) {
   if (brand & transparent_mask) {
     // Reject attempts to receive through a transparent (client) key.
@@ -12,6 +12,8 @@
  * - Otherwise, the sender is blocked until a receive happens.
  */
 
+#include <cstddef>
+
 #include "common/abi_types.h"
 
 #include "k/object.h"
@@ -21,6 +23,7 @@ namespace k {
 
 struct Context;  // see: k/context.h
 struct BlockingSender;  // see: k/blocking_sender.h
+struct ScopedReplySender;  // see: k/reply_sender.h
 
 class Gate final : public Object {
 public:
@@ -29,14 +32,23 @@ public:
     List<Context> receivers;
   };
 
-  Gate(Generation g, Body & body) : Object{g}, _body(body) {}
+  /*
+   * Creates a Gate whose body occupies 'body_size' bytes, which may be more
+   * than sizeof(Body).  The size is remembered so that the whole extent can
+   * be returned as Memory when the Gate is destroyed.
+   */
+  Gate(Generation g, Body & body, size_t body_size)
+    : Object{g, Kind::gate}, _body(body), _body_size(body_size) {}
 
   void deliver_from(Brand const &, Sender *) override;
   void deliver_to(Brand const &, Context *) override;
-  Kind get_kind() const override { return Kind::gate; }
 
 private:
   Body & _body;
+  size_t _body_size;
+
+  void do_discharge_one(ScopedReplySender &);
+  void do_destroy(ScopedReplySender &);
 };
 
 }  // namespace k
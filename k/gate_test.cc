@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "etl/armv7m/sys_tick.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/context.h"
+#include "k/gate.h"
+#include "k/interrupt.h"
+#include "k/irq_redirector.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+using etl::armv7m::sys_tick;
+
+namespace S = selector::gate;
+
+// Interrupt identifier of SysTick, which (unlike the NVIC) is faked in tests.
+static constexpr uint32_t sys_tick_identifier = ~uint32_t(0);
+
+class GateTest : public ::testing::Test {
+protected:
+  ObjectTable::Entry _entries[4];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  // A Context to park on the Gate's lists.  It never runs.
+  Context::Body _waiter_body;
+  Context _waiter{0, _waiter_body, sizeof(_waiter_body)};
+
+  Gate::Body _gate_body;
+
+  // An Interrupt that can send to the Gate.
+  Interrupt::Body _irq_body{sys_tick_identifier};
+  Interrupt * _irq_table[1];
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Gate{0, _gate_body, sizeof(_gate_body)};
+
+    set_irq_redirection_table(_irq_table);
+    new(&_entries[3]) Interrupt{0, _irq_body, sizeof(_irq_body)};
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    _waiter_body.ctx_item.unlink();
+    _waiter_body.sender_item.unlink();
+    _irq_body.sender_item.unlink();
+    current = nullptr;
+    reset_irq_redirection_table_for_test();
+    reset_object_table_for_test();
+  }
+
+  Interrupt & interrupt() {
+    return *static_cast<Interrupt *>(&_entries[3].as_object());
+  }
+
+  Object & object() {
+    return _entries[2].as_object();
+  }
+
+  Message const & send_from_spy(Message m) {
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    object().deliver_from(0, &_sender);
+
+    EXPECT_EQ(1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+};
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+/*
+ * Discharge One
+ */
+
+TEST_F(GateTest, discharge_one_empty) {
+  auto & m = send_from_spy({Descriptor::call(S::discharge_one, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0, m.d0) << "nobody should have been discharged";
+}
+
+TEST_F(GateTest, discharge_one_sender) {
+  // As if blocked in send.
+  _gate_body.senders.insert(&_waiter_body.sender_item);
+  _waiter_body.state = Context::State::sending;
+
+  auto & m = send_from_spy({Descriptor::call(S::discharge_one, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0) << "a sender should have been discharged";
+
+  ASSERT_FALSE(_waiter_body.sender_item.is_linked());
+  ASSERT_TRUE(_gate_body.senders.is_empty());
+  ASSERT_EQ(Context::State::runnable, _waiter_body.state);
+  ASSERT_RETURNED_EXCEPTION(_waiter_body.save.sys.m, Exception::abandoned);
+}
+
+TEST_F(GateTest, discharge_one_receiver) {
+  _waiter.block_in_receive(_gate_body.receivers);
+
+  auto & m = send_from_spy({Descriptor::call(S::discharge_one, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(2, m.d0) << "a receiver should have been discharged";
+
+  ASSERT_TRUE(_gate_body.receivers.is_empty());
+  ASSERT_EQ(Context::State::runnable, _waiter_body.state);
+  ASSERT_TRUE(_waiter_body.ctx_item.is_linked())
+    << "receiver should be on the run queue";
+  ASSERT_RETURNED_EXCEPTION(_waiter_body.save.sys.m, Exception::abandoned);
+}
+
+TEST_F(GateTest, discharge_one_interrupt) {
+  sys_tick.write_csr(sys_tick.read_csr().with_tickint(true));
+  _irq_body.target = object().make_key(Brand(1) << 63).ref();
+
+  // With nobody receiving, the Interrupt disables itself and waits.
+  interrupt().trigger();
+  ASSERT_TRUE(_irq_body.sender_item.is_linked());
+  ASSERT_FALSE(sys_tick.read_csr().get_tickint());
+
+  auto & m = send_from_spy({Descriptor::call(S::discharge_one, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0);
+
+  ASSERT_FALSE(_irq_body.sender_item.is_linked());
+  ASSERT_TRUE(sys_tick.read_csr().get_tickint())
+    << "discharged Interrupt should be re-enabled";
+}
+
+/*
+ * Destroy
+ */
+
+TEST_F(GateTest, destroy_with_receiver) {
+  _gate_body.receivers.insert(&_waiter_body.ctx_item);
+
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_EQ(Object::Kind::gate, object().get_kind());
+  ASSERT_EQ(0, object().get_generation());
+  ASSERT_TRUE(_waiter_body.ctx_item.is_linked())
+    << "refusal must leave the receiver waiting";
+}
+
+TEST_F(GateTest, destroy_with_sender) {
+  _gate_body.senders.insert(&_waiter_body.sender_item);
+
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_EQ(Object::Kind::gate, object().get_kind());
+  ASSERT_TRUE(_waiter_body.sender_item.is_linked())
+    << "refusal must leave the sender waiting";
+}
+
+TEST_F(GateTest, destroy_empty) {
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(1, object().get_generation())
+    << "destroying should revoke keys to the Gate";
+
+  auto & mem = static_cast<Memory &>(object());
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(&_gate_body), mem.get_base());
+  ASSERT_EQ(sizeof(_gate_body), mem.get_size());
+
+  auto & k = _spy.keys().keys[1];
+  ASSERT_EQ(&mem, k.get());
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
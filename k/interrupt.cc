@@ -7,6 +7,7 @@
 #include "common/abi_sizes.h"
 #include "common/selectors.h"
 
+#include "k/become.h"
 #include "k/irq_redirector.h"
 #include "k/reply_sender.h"
 
@@ -21,8 +22,8 @@ template struct ObjectSubclassChecks<Interrupt, kabi::interrupt_size>;
 
 static constexpr uint32_t sys_tick_identifier = ~uint32_t(0);
 
-Interrupt::Interrupt(Generation g, Body & body)
-  : Object{g}, _body(body) {
+Interrupt::Interrupt(Generation g, Body & body, size_t body_size)
+  : Object{g, Kind::interrupt}, _body(body), _body_size(body_size) {
   _body.sender_item.owner = this;
   get_irq_redirection_table()[get_identifier() + 1] = this;
 }
@@ -52,6 +53,10 @@ void Interrupt::deliver_from(Brand const & brand, Sender * sender) {
       do_enable(brand, m, k);
       break;
 
+    case S::destroy:
+      do_destroy(brand, m, k);
+      break;
+
     default:
       do_badop(m, k);
       break;
@@ -76,6 +81,13 @@ void Interrupt::do_enable(Brand const &, Message const & m, Keys & k) {
   enable_interrupt();
 }
 
+void Interrupt::do_destroy(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  destroy_object(*this, &_body, _body_size, reply_sender);
+  // Note: 'this' may no longer be an Interrupt.
+}
+
 Priority Interrupt::get_priority() const {
   return _body.priority;
 }
@@ -104,35 +116,40 @@ ReceivedMessage Interrupt::on_blocked_delivery(KeysRef k) {
   };
 }
 
-void Interrupt::on_blocked_delivery_aborted() {
-  // We appear to have been interrupted while blocked.
-  // TODO: do we need to do something?
+void Interrupt::on_blocked_delivery_aborted(Exception) {
+  // Our message was discarded (e.g. by Gate discharge), so nobody is going to
+  // enable us in response to it.  Rather than go quiet forever, re-arm, so
+  // the next occurrence -- or this one, if still pending -- gets through.
+  enable_interrupt();
 }
 
+// SysTick is faked in hosted builds (see k/testutil/sys_tick_fake.cc), so
+// tests can observe it being enabled and disabled; the NVIC is not.
+
 void Interrupt::disable_interrupt() {
-#ifndef HOSTED_KERNEL_BUILD
   auto id = get_identifier();
   if (id == sys_tick_identifier) {
     // SysTick
     sys_tick.write_csr(sys_tick.read_csr().with_tickint(false));
   } else {
+#ifndef HOSTED_KERNEL_BUILD
     // Boring old interrupt.
     nvic.disable_irq(get_identifier());
-  }
 #endif
+  }
 }
 
 void Interrupt::enable_interrupt() {
-#ifndef HOSTED_KERNEL_BUILD
   auto id = get_identifier();
   if (id == sys_tick_identifier) {
     // SysTick
     sys_tick.write_csr(sys_tick.read_csr().with_tickint(true));
   } else {
+#ifndef HOSTED_KERNEL_BUILD
     // Boring old interrupt.
     nvic.enable_irq(get_identifier());
-  }
 #endif
+  }
 }
 
 void Interrupt::clear_pending_interrupt() {
@@ -5,6 +5,7 @@
  * Controls an interrupt and generates messages when it occurs.
  */
 
+#include <cstddef>
 #include <cstdint>
 
 #include "k/blocking_sender.h"
@@ -28,7 +29,7 @@ public:
         identifier{id} {}
   };
 
-  Interrupt(Generation g, Body & body);
+  Interrupt(Generation g, Body & body, size_t body_size);
 
   /*
    * Triggers this interrupt.  Should be called from an ISR.
@@ -42,7 +43,6 @@ public:
    * must arrive through a gate.
    */
 
-  Kind get_kind() const override { return Kind::interrupt; }
   void deliver_from(Brand const &, Sender *) override;
 
   /*
@@ -56,15 +56,17 @@ public:
    */
   Priority get_priority() const override;
   ReceivedMessage on_blocked_delivery(KeysRef) override;
-  void on_blocked_delivery_aborted() override;
+  void on_blocked_delivery_aborted(Exception) override;
 
 private:
   Body & _body;
+  size_t _body_size;
 
   uint32_t get_identifier() const { return _body.identifier; }
 
   void do_set_target(Brand const &, Message const &, Keys &);
   void do_enable(Brand const &, Message const &, Keys &);
+  void do_destroy(Brand const &, Message const &, Keys &);
 
   void disable_interrupt();
   void clear_pending_interrupt();
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "etl/armv7m/sys_tick.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/context.h"
+#include "k/interrupt.h"
+#include "k/irq_redirector.h"
+#include "k/list.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+using etl::armv7m::sys_tick;
+
+namespace S = selector::interrupt;
+
+// Interrupt identifier of SysTick, which (unlike the NVIC) is faked in tests.
+static constexpr uint32_t sys_tick_identifier = ~uint32_t(0);
+
+class InterruptTest : public ::testing::Test {
+protected:
+  ObjectTable::Entry _entries[3];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  Interrupt::Body _irq_body{sys_tick_identifier};
+  // SysTick's entry comes first in the redirection table.
+  Interrupt * _irq_table[1];
+
+  // Stands in for a Gate's sender list.
+  List<BlockingSender> _senders;
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    sys_tick.write_csr(sys_tick.read_csr().with_tickint(false));
+    set_irq_redirection_table(_irq_table);
+    new(&_entries[2]) Interrupt{0, _irq_body, sizeof(_irq_body)};
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    _irq_body.sender_item.unlink();
+    current = nullptr;
+    reset_irq_redirection_table_for_test();
+    reset_object_table_for_test();
+  }
+
+  Object & object() {
+    return _entries[2].as_object();
+  }
+
+  Message const & send_from_spy(Message m) {
+    auto count = _spy.count();
+
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    object().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+};
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+TEST_F(InterruptTest, registers_itself) {
+  ASSERT_EQ(&object(), _irq_table[0]);
+}
+
+/*
+ * Enable
+ */
+
+TEST_F(InterruptTest, enable) {
+  auto & m = send_from_spy({Descriptor::call(S::enable, 0), 0});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_TRUE(sys_tick.read_csr().get_tickint());
+}
+
+/*
+ * Destroy
+ */
+
+TEST_F(InterruptTest, destroy) {
+  auto irq_key = object().make_key(0).ref();
+  send_from_spy({Descriptor::call(S::enable, 0), 0});
+
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_FALSE(sys_tick.read_csr().get_tickint())
+    << "a destroyed Interrupt must not leave its interrupt enabled";
+  ASSERT_EQ(nullptr, _irq_table[0])
+    << "a destroyed Interrupt must leave the redirection table";
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(&object(), _spy.keys().keys[1].get());
+  ASSERT_EQ(Object::Kind::null, irq_key.get()->get_kind())
+    << "keys to the Interrupt must be revoked";
+}
+
+TEST_F(InterruptTest, destroy_while_sending) {
+  static_cast<Interrupt &>(object()).block_in_send(0, _senders);
+  ASSERT_FALSE(_senders.is_empty());
+
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_TRUE(_senders.is_empty())
+    << "a destroyed Interrupt must stop waiting to send";
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
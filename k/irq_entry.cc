@@ -8,6 +8,7 @@
 #include "k/irq_redirector.h"
 #include "k/panic.h"
 #include "k/scheduler.h"
+#include "k/timer.h"
 
 namespace k {
 
@@ -31,7 +32,20 @@ void irq_redirector() {
   etl::armv7m::enable_interrupts();
 }
 
+void sys_tick_redirector() {
+  etl::armv7m::disable_interrupts();
+
+  // The SysTick drives the kernel clock whether or not an Interrupt object
+  // has claimed it.
+  Timer::tick();
+
+  if (auto handler = get_irq_redirection_table()[0]) handler->trigger();
+  do_deferred_switch_from_irq();
+
+  etl::armv7m::enable_interrupts();
+}
+
 }  // namespace k
 
 void etl_armv7m_sys_tick_handler()
-  __attribute__((alias("_ZN1k14irq_redirectorEv")));
+  __attribute__((alias("_ZN1k19sys_tick_redirectorEv")));
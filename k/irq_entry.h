@@ -4,6 +4,7 @@
 namespace k {
 
 void irq_redirector();
+void sys_tick_redirector();
 
 }  // namespace k
 
@@ -1,5 +1,8 @@
 #include "k/key.h"
 
+#include "etl/prediction.h"
+
+#include "k/dispatch.h"
 #include "k/object.h"
 #include "k/object_table.h"
 #include "k/panic.h"
@@ -8,28 +11,71 @@ namespace k {
 
 Key Key::filled(Object * ptr, Brand const & brand) {
   PANIC_UNLESS(ptr, "nullptr in Key::filled");
+  PANIC_UNLESS(can_hold(brand), "unrepresentable brand in Key::filled");
 
   Key k;
 
+#ifdef KERNEL_COMPACT_KEYS
+  auto index = object_table().index_of(*ptr);
+  PANIC_UNLESS(index <= UINT16_MAX, "object index too big for Key");
+
+  k._brand = uint32_t(brand) | uint32_t(brand >> 32);
+  k._generation = uint16_t(ptr->get_generation());
+  k._index = uint16_t(index);
+#else
   k._brand = brand;
   k._generation = ptr->get_generation();
   k._ptr = ptr;
+#endif
   return k;
 }
 
-Key Key::null() {
-  return object_table()[0].make_key(0).ref();
+/*
+ * Stale keys are overwritten with the canonical null key, rather than a key
+ * minted by the Null Object, so that revocation costs a store and not a
+ * virtual call.  This relies on the Null Object keeping generation zero; the
+ * Object Table refuses to invalidate it.
+ */
+
+#ifdef KERNEL_COMPACT_KEYS
+
+Object * Key::get() {
+  auto ptr = &object_table()[_index];
+  if (ETL_UNLIKELY(_generation != uint16_t(ptr->get_generation()))) {
+    *this = null();
+    ptr = &object_table()[0];
+  }
+  return ptr;
 }
 
+#else
+
 Object * Key::get() {
-  if (!_ptr || _generation != _ptr->get_generation()) {
+  if (ETL_LIKELY(_ptr)) {
+    if (ETL_LIKELY(_generation == _ptr->get_generation())) return _ptr;
     *this = null();
   }
-  return _ptr;
+  return &object_table()[0];
 }
 
+#endif
+
+#ifdef KERNEL_COMPACT_KEYS
+
+bool Key::designates(Object const & o) const {
+  return &object_table()[_index] == &o;
+}
+
+#else
+
+bool Key::designates(Object const & o) const {
+  return (_ptr ? _ptr : &object_table()[0]) == &o;
+}
+
+#endif
+
 void Key::deliver_from(Sender * sender) {
-  get()->deliver_from(_brand, sender);
+  dispatch::deliver_from(*get(), get_brand(), sender);
 }
 
 }  // namespace k
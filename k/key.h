@@ -1,6 +1,8 @@
 #ifndef K_KEY_H
 #define K_KEY_H
 
+#include <cstdint>
+
 #include "common/abi_types.h"
 
 namespace k {
@@ -10,29 +12,89 @@ struct Sender;  // see: k/sender.h
 
 /*
  * A Key is the data structure used to reference kernel objects.
+ *
+ * By default a Key holds a full 64-bit brand, 32-bit generation, and a direct
+ * pointer to the object, for 16 bytes in total.  Defining KERNEL_COMPACT_KEYS
+ * selects an 8-byte representation instead, which stores the object's table
+ * index, the low 16 bits of its generation, and a 32-bit brand.  This roughly
+ * halves the space used by keys in Context bodies and the data moved per IPC,
+ * in exchange for:
+ * - An extra indirection through the Object Table on each use.
+ * - Protection against key resurrection for only 2^16 generations.
+ * - Brands restricted to those matching brand_mask, below.
  */
 class Key {
 public:
+#ifdef KERNEL_COMPACT_KEYS
+  /*
+   * Brand bits that can be stored in a Key: the top bit, which many objects use
+   * to distinguish classes of keys, and the low 31 bits.
+   */
+  static constexpr Brand brand_mask = (Brand(1) << 63) | 0x7FFFFFFF;
+#else
+  static constexpr Brand brand_mask = ~Brand(0);
+#endif
+
+  /*
+   * Generation bits compared when a Key is used.  Generations that agree in
+   * these bits are indistinguishable.
+   */
+#ifdef KERNEL_COMPACT_KEYS
+  static constexpr Generation generation_mask = 0xFFFF;
+#else
+  static constexpr Generation generation_mask = ~Generation(0);
+#endif
+
+  /*
+   * Checks whether a Key can hold the given brand.  Objects should refuse to
+   * make keys with brands that fail this check.
+   */
+  static constexpr bool can_hold(Brand const & brand) {
+    return (brand & ~brand_mask) == 0;
+  }
+
   /*
    * Static factory function for producing a key filled in with the
    * given object and brand.
+   *
+   * Precondition: can_hold(brand).
    */
   static Key filled(Object *, Brand const & brand);
 
   /*
-   * Static factory function for producing a null key.
+   * Static factory function for producing a null key.  This is the canonical
+   * null key, with all fields zero -- the same as a value-initialized Key --
+   * which designates the Null Object at table index zero.  Revoked keys are
+   * replaced with this.
    */
-  static Key null();
+  static constexpr Key null() { return Key{}; }
 
   /*
    * Gets the brand stored within this key.
    */
-  Brand const & get_brand() const { return _brand; }
+#ifdef KERNEL_COMPACT_KEYS
+  Brand get_brand() const {
+    return Brand(_brand & 0x7FFFFFFF) | (Brand(_brand >> 31) << 63);
+  }
+#else
+  Brand get_brand() const { return _brand; }
+#endif
 
   Generation get_generation() const { return _generation; }
 
+  /*
+   * Gets the object referenced by this key, or the Null Object if the key is
+   * null or has been revoked.  Revoked keys are nulled as a side effect.
+   */
   Object * get();
 
+  /*
+   * Checks whether this key refers to the given object's table entry,
+   * ignoring generation: a key revoked by invalidating the object still
+   * designates it.  Unlike get(), this never modifies the key.
+   */
+  bool designates(Object const &) const;
+
   /*
    * Facade function for Object::deliver_from; calls through to the
    * referenced object, supplemented by this key's brand.
@@ -40,13 +102,22 @@ public:
   void deliver_from(Sender *);
 
 private:
+#ifdef KERNEL_COMPACT_KEYS
+  // Brand, with bit 63 moved down to bit 31.
+  std::uint32_t _brand;
+  // Low bits of the generation of the object table slot.
+  std::uint16_t _generation;
+  // Object table index.
+  std::uint16_t _index;
+#else
   // Uninterpreted data, invisible to the key holder, but  made available to
   // the object when the key is used.
   Brand _brand;
   // Distinguishes successive occupants of a single object table slot.
   Generation _generation;
-  // Object pointer.
+  // Object pointer, or nullptr, meaning the Null Object.
   Object * _ptr;
+#endif
 };
 
 }  // namespace k
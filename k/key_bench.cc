@@ -0,0 +1,124 @@
+/*
+ * Host microbenchmark for Key::get, particularly on revoked keys.
+ *
+ * After a server is restarted, its clients may all use stale keys to it at
+ * once, so the cost of discovering and nulling a stale key matters as much as
+ * the cost of using a live one.  This measures:
+ *
+ * - live: get() on a current key.
+ * - stale: get() on a key whose object has been invalidated, which nulls it.
+ * - null: get() on a key that has already been nulled.
+ * - xfer: moving a message's worth of keys between Key Registers through
+ *   KeysRef maps, as every IPC does.
+ *
+ * This is built with both Key representations.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+#include "k/config.h"
+#include "k/key.h"
+#include "k/keys.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/slot.h"
+
+namespace k {
+
+static constexpr unsigned iterations = 10 * 1000 * 1000;
+
+// Keys used per iteration; large enough that the stale copies aren't all
+// sitting in registers.
+static constexpr unsigned batch = 64;
+
+static ObjectTable::Entry entries[3];
+
+static Key live_keys[batch], stale_keys[batch], work[batch];
+
+static void set_up() {
+  new (&entries[0]) NullObject{0};
+
+  {
+    auto o = new(&entries[1]) ObjectTable{0};
+    set_object_table(o);
+    o->set_entries(entries);
+  }
+
+  auto & slot = *new(&entries[2]) Slot{0};
+
+  for (auto & k : stale_keys) k = slot.make_key(0).ref();
+  slot.invalidate();
+  for (auto & k : live_keys) k = slot.make_key(0).ref();
+}
+
+template <typename Prep>
+static void measure(char const * name, Prep && prep) {
+  std::chrono::nanoseconds total{0};
+  uintptr_t sink = 0;
+
+  for (unsigned i = 0; i < iterations / batch; ++i) {
+    // Refill outside the timed region, so that stale keys stay stale.
+    prep();
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto & k : work) sink += reinterpret_cast<uintptr_t>(k.get());
+    total += std::chrono::steady_clock::now() - start;
+  }
+
+  std::printf("%-6s %8.2f ns/op (%lx)\n",
+      name,
+      double(total.count()) / (iterations / batch * batch),
+      static_cast<unsigned long>(sink & 1));
+}
+
+static void copy(Key const (&from)[batch]) {
+  for (unsigned i = 0; i < batch; ++i) work[i] = from[i];
+}
+
+static Key sender_regs[config::n_task_keys], receiver_regs[config::n_task_keys];
+
+static void measure_transfer() {
+  for (auto & k : sender_regs) k = live_keys[0];
+
+  // Typical maps: the sender's keys from a few registers, the receiver's
+  // into others.
+  KeysRef from{sender_regs, 0x4321}, to{receiver_regs, 0x8765};
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; ++i) {
+    for (unsigned ki = 0; ki < config::n_message_keys; ++ki) {
+      to.set(ki, from.get(ki));
+    }
+    // Keep the compiler from collapsing the iterations.
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+  std::printf("%-6s %8.2f ns/op (%u keys)\n",
+      "xfer",
+      double(ns.count()) / iterations,
+      config::n_message_keys);
+}
+
+}  // namespace k
+
+int main() {
+#ifdef KERNEL_COMPACT_KEYS
+  std::printf("keys: compact\n");
+#else
+  std::printf("keys: full\n");
+#endif
+
+  k::set_up();
+  k::measure("live", [] { k::copy(k::live_keys); });
+  k::measure("stale", [] { k::copy(k::stale_keys); });
+  // The stale pass left the work keys nulled.
+  k::measure("null", [] {});
+  k::measure_transfer();
+  k::reset_object_table_for_test();
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "common/abi_sizes.h"
+
+#include "k/context.h"
+#include "k/key.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/slot.h"
+
+/*
+ * Tests for Key behavior common to both representations.  This file is built
+ * twice, with and without KERNEL_COMPACT_KEYS.
+ */
+
+namespace k {
+
+class KeyTest : public ::testing::Test {
+protected:
+  ObjectTable::Entry _entries[4];
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Slot{0};
+    new(&_entries[3]) Slot{0};
+  }
+
+  void TearDown() override {
+    reset_object_table_for_test();
+  }
+
+  Object & slot() {
+    return _entries[2].as_object();
+  }
+
+  Object & other_slot() {
+    return _entries[3].as_object();
+  }
+};
+
+#define ASSERT_NULL_KEY(__k) \
+  ASSERT_EQ(Object::Kind::null, (__k).get()->get_kind())
+
+TEST_F(KeyTest, sizes) {
+#ifdef KERNEL_COMPACT_KEYS
+  ASSERT_EQ(8, sizeof(Key));
+#else
+  ASSERT_EQ(16, sizeof(Key));
+#endif
+  ASSERT_LE(sizeof(Context::Body), kabi::context_size);
+}
+
+TEST_F(KeyTest, default_is_null) {
+  Key k{};
+  ASSERT_NULL_KEY(k);
+}
+
+TEST_F(KeyTest, null_is_canonical) {
+  constexpr Key k_const = Key::null();
+  Key k = k_const;
+
+  ASSERT_EQ(&_entries[0].as_object(), k.get());
+  ASSERT_EQ(0, k.get_brand());
+  ASSERT_EQ(0, k.get_generation());
+}
+
+TEST_F(KeyTest, round_trip) {
+  auto k = slot().make_key(0x12345678).ref();
+
+  ASSERT_EQ(&slot(), k.get());
+  ASSERT_EQ(0x12345678, k.get_brand());
+  ASSERT_EQ(slot().get_generation(), k.get_generation());
+
+  auto k2 = other_slot().make_key(0).ref();
+  ASSERT_EQ(&other_slot(), k2.get());
+}
+
+TEST_F(KeyTest, round_trip_top_bit) {
+  auto brand = (Brand(1) << 63) | 0x7FFFFFFF;
+  auto k = slot().make_key(brand).ref();
+
+  ASSERT_EQ(&slot(), k.get());
+  ASSERT_EQ(brand, k.get_brand());
+}
+
+TEST_F(KeyTest, middle_brand_bits) {
+  auto brand = Brand(1) << 40;
+  auto maybe_key = slot().make_key(brand);
+
+#ifdef KERNEL_COMPACT_KEYS
+  ASSERT_FALSE(maybe_key) << "compact keys cannot hold brand bits 31-62";
+#else
+  ASSERT_TRUE(maybe_key);
+  ASSERT_EQ(brand, maybe_key.ref().get_brand());
+#endif
+}
+
+TEST_F(KeyTest, revocation) {
+  auto k = slot().make_key(0).ref();
+  slot().invalidate();
+
+  ASSERT_NULL_KEY(k);
+  ASSERT_EQ(0, k.get_brand()) << "revoked key should be nulled";
+  ASSERT_EQ(0, k.get_generation()) << "revoked key should be nulled";
+  ASSERT_EQ(&_entries[0].as_object(), k.get());
+}
+
+TEST_F(KeyTest, revocation_is_per_object) {
+  auto k = slot().make_key(0).ref();
+  auto k2 = other_slot().make_key(0).ref();
+  other_slot().invalidate();
+
+  ASSERT_EQ(&slot(), k.get());
+  ASSERT_NULL_KEY(k2);
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
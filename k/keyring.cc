@@ -0,0 +1,100 @@
+#include "k/keyring.h"
+
+#include "common/selectors.h"
+
+#include "k/become.h"
+#include "k/config.h"
+#include "k/keys.h"
+#include "k/reply_sender.h"
+#include "k/sender.h"
+
+namespace k {
+
+template struct ObjectSubclassChecks<Keyring, 0>;
+
+void Keyring::deliver_from(Brand const & brand, Sender * sender) {
+  Keys k;
+  Message m = sender->on_delivery(k);
+
+  namespace S = selector::keyring;
+  switch (m.desc.get_selector()) {
+    case S::load:
+      do_load(brand, m, k);
+      break;
+
+    case S::store:
+      do_store(brand, m, k);
+      break;
+
+    case S::get_size:
+      do_get_size(brand, m, k);
+      break;
+
+    case S::destroy:
+      do_destroy(brand, m, k);
+      break;
+
+    default:
+      do_badop(m, k);
+      break;
+  }
+}
+
+/*
+ * Checks the index (d0) and count (d1) of a load or store request, sending an
+ * exception reply if they're unacceptable.  Key 0 carries the reply, so at
+ * most n_message_keys - 1 keys can move per operation.
+ */
+bool Keyring::check_range(Message const & m, Keys & k) {
+  auto index = m.d0;
+  auto count = m.d1;
+
+  if (count == 0 || count >= config::n_message_keys) {
+    ScopedReplySender reply_sender{k.keys[0],
+      Message::failure(Exception::bad_argument)};
+    return false;
+  }
+
+  if (index >= _keys.count() || count > _keys.count() - index) {
+    ScopedReplySender reply_sender{k.keys[0],
+      Message::failure(Exception::index_out_of_range)};
+    return false;
+  }
+
+  return true;
+}
+
+void Keyring::do_load(Brand const &, Message const & m, Keys & k) {
+  if (!check_range(m, k)) return;
+
+  ScopedReplySender reply_sender{k.keys[0]};
+  for (unsigned i = 0; i < m.d1; ++i) {
+    auto & key = _keys[m.d0 + i];
+    // Drop revoked keys as we find them.
+    key.get();
+    reply_sender.set_key(1 + i, key);
+  }
+}
+
+void Keyring::do_store(Brand const &, Message const & m, Keys & k) {
+  if (!check_range(m, k)) return;
+
+  ScopedReplySender reply_sender{k.keys[0]};
+  for (unsigned i = 0; i < m.d1; ++i) {
+    _keys[m.d0 + i] = k.keys[1 + i];
+  }
+}
+
+void Keyring::do_get_size(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+  reply_sender.message().d0 = uint32_t(_keys.count());
+}
+
+void Keyring::do_destroy(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  destroy_object(*this, _keys.base(), _body_size, reply_sender);
+  // Note: 'this' may no longer be a Keyring.
+}
+
+}  // namespace k
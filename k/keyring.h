@@ -0,0 +1,55 @@
+#ifndef K_KEYRING_H
+#define K_KEYRING_H
+
+/*
+ * A Keyring is a bounded array of Keys, stored in donated memory.
+ *
+ * Keyrings give programs somewhere to keep more keys than fit in a Context's
+ * key registers.  Keys are moved between the Keyring and the message keys of
+ * an IPC, several at a time, by index.
+ */
+
+#include <cstddef>
+
+#include "k/key.h"
+#include "k/object.h"
+#include "k/range_ptr.h"
+
+namespace k {
+
+class Keyring final : public Object {
+public:
+  /*
+   * Creates a Keyring using 'keys' as storage.  The Keys must already be
+   * constructed.  'body_size' gives the size of the donated memory holding
+   * them, which may include a few bytes beyond the last Key.
+   */
+  Keyring(Generation g, RangePtr<Key> keys, size_t body_size)
+    : Object{g, Kind::keyring}, _keys(keys), _body_size(body_size) {}
+
+  /*
+   * Direct access to the Keys, for kernel code that uses a Keyring as a table
+   * (such as a Context's region cache).
+   */
+  RangePtr<Key> keys() const { return _keys; }
+
+  /*
+   * Implementation of Object.
+   */
+  void deliver_from(Brand const &, Sender *) override;
+
+private:
+  RangePtr<Key> _keys;
+  size_t _body_size;
+
+  bool check_range(Message const &, Keys &);
+
+  void do_load(Brand const &, Message const &, Keys &);
+  void do_store(Brand const &, Message const &, Keys &);
+  void do_get_size(Brand const &, Message const &, Keys &);
+  void do_destroy(Brand const &, Message const &, Keys &);
+};
+
+}  // namespace k
+
+#endif  // K_KEYRING_H
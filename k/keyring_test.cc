@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/config.h"
+#include "k/context.h"
+#include "k/keyring.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+namespace S = selector::keyring;
+
+class KeyringTest : public ::testing::Test {
+protected:
+  static constexpr unsigned ring_size = 4;
+
+  ObjectTable::Entry _entries[3];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  Key _ring[ring_size]{};
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Keyring{0, {_ring, ring_size}, sizeof(_ring)};
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  Object & object() {
+    return _entries[2].as_object();
+  }
+
+  // Keys to the Object Table, told apart by brand.
+  Key marked_key(Brand brand) {
+    return _entries[1].as_object().make_key(brand).ref();
+  }
+
+  Message const & send_from_spy(Message m) {
+    auto count = _spy.count();
+
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    object().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+
+  Message const & load(unsigned index, unsigned count) {
+    return send_from_spy({Descriptor::call(S::load, 0), index, count});
+  }
+
+  Message const & store(unsigned index, unsigned count) {
+    auto & m = send_from_spy({Descriptor::call(S::store, 0), index, count});
+    for (unsigned i = 1; i < config::n_message_keys; ++i) {
+      _sender.set_key(i, Key::null());
+    }
+    return m;
+  }
+};
+
+constexpr unsigned KeyringTest::ring_size;
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+#define ASSERT_MARKED_KEY(_key, _brand) \
+{ \
+  auto & __key = (_key); \
+  ASSERT_EQ(Object::Kind::object_table, __key.get()->get_kind()); \
+  ASSERT_EQ(Brand(_brand), __key.get_brand()); \
+}
+
+#define ASSERT_NULL_KEY(_key) \
+  ASSERT_EQ(Object::Kind::null, (_key).get()->get_kind())
+
+/*
+ * Load and Store
+ */
+
+TEST_F(KeyringTest, store_then_load) {
+  _sender.set_key(1, marked_key(11));
+  _sender.set_key(2, marked_key(12));
+  auto & m = store(1, 2);
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_NULL_KEY(_ring[0]);
+  ASSERT_MARKED_KEY(_ring[1], 11);
+  ASSERT_MARKED_KEY(_ring[2], 12);
+  ASSERT_NULL_KEY(_ring[3]);
+
+  auto & m2 = load(1, 3);
+  ASSERT_MESSAGE_SUCCESS(m2);
+  ASSERT_MARKED_KEY(_spy.keys().keys[1], 11);
+  ASSERT_MARKED_KEY(_spy.keys().keys[2], 12);
+  ASSERT_NULL_KEY(_spy.keys().keys[3]);
+}
+
+TEST_F(KeyringTest, store_last) {
+  _sender.set_key(1, marked_key(7));
+  auto & m = store(ring_size - 1, 1);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_MARKED_KEY(_ring[ring_size - 1], 7);
+}
+
+TEST_F(KeyringTest, load_count_zero) {
+  ASSERT_RETURNED_EXCEPTION(load(0, 0), Exception::bad_argument);
+}
+
+TEST_F(KeyringTest, load_count_too_big) {
+  ASSERT_RETURNED_EXCEPTION(load(0, config::n_message_keys),
+                            Exception::bad_argument);
+}
+
+TEST_F(KeyringTest, store_count_too_big) {
+  ASSERT_RETURNED_EXCEPTION(store(0, config::n_message_keys),
+                            Exception::bad_argument);
+}
+
+TEST_F(KeyringTest, load_index_at_end) {
+  ASSERT_RETURNED_EXCEPTION(load(ring_size, 1),
+                            Exception::index_out_of_range);
+}
+
+TEST_F(KeyringTest, load_past_end) {
+  ASSERT_RETURNED_EXCEPTION(load(ring_size - 1, 2),
+                            Exception::index_out_of_range);
+}
+
+TEST_F(KeyringTest, store_past_end) {
+  _sender.set_key(1, marked_key(1));
+  _sender.set_key(2, marked_key(2));
+  ASSERT_RETURNED_EXCEPTION(store(ring_size - 1, 2),
+                            Exception::index_out_of_range);
+  ASSERT_NULL_KEY(_ring[ring_size - 1])
+    << "failed store should leave the Keyring unchanged";
+}
+
+TEST_F(KeyringTest, load_huge_index) {
+  // Shouldn't wrap around when added to the count.
+  ASSERT_RETURNED_EXCEPTION(load(~0u, 2), Exception::index_out_of_range);
+}
+
+/*
+ * Get Size
+ */
+
+TEST_F(KeyringTest, get_size) {
+  auto & m = send_from_spy({Descriptor::call(S::get_size, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(ring_size, m.d0);
+}
+
+/*
+ * Destroy
+ */
+
+TEST_F(KeyringTest, destroy) {
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(1, object().get_generation())
+    << "destroying should revoke keys to the Keyring";
+
+  auto & mem = static_cast<Memory &>(object());
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(&_ring[0]), mem.get_base());
+  ASSERT_EQ(sizeof(_ring), mem.get_size());
+  ASSERT_EQ(&mem, _spy.keys().keys[1].get());
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
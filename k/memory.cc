@@ -9,7 +9,9 @@
 #include "common/selectors.h"
 
 #include "k/become.h"
+#include "k/config.h"
 #include "k/context.h"
+#include "k/object_table.h"
 #include "k/panic.h"
 #include "k/region.h"
 #include "k/reply_sender.h"
@@ -34,6 +36,106 @@ static constexpr bool contains(uintptr_t parent_base, size_t parent_size,
 }
 
 
+/*
+ * Finds the smallest MPU region that covers exactly the given range, using
+ * subregion disables if necessary.  On success, returns true and produces the
+ * region's log2(size/2) and the subregion disable bits for the parts of it
+ * outside the range.
+ *
+ * The ARMv7-M MPU requires regions to be naturally aligned powers of two, at
+ * least 32 bytes in size, and only supports subregions (eighths) in regions of
+ * 256 bytes or more.
+ */
+static bool find_covering_region(uintptr_t base,
+                                 size_t size,
+                                 unsigned & l2_half_size_out,
+                                 uint8_t & srd_out) {
+  if (size < 32) return false;
+
+  for (unsigned l2_half_size = 4; l2_half_size < 31; ++l2_half_size) {
+    uint32_t region_size = 2u << l2_half_size;
+    if (region_size < size) continue;
+
+    uintptr_t region_base = base & ~(region_size - 1);
+    auto start = base - region_base;
+    auto end = start + size;
+    if (end > region_size) continue;
+
+    if (start == 0 && end == region_size) {
+      l2_half_size_out = l2_half_size;
+      srd_out = 0;
+      return true;
+    }
+
+    if (region_size < 256) continue;
+
+    // Subregions only get coarser in larger regions, so if the range doesn't
+    // fall on subregion boundaries here, it never will.
+    auto subregion_size = region_size / 8;
+    if (start % subregion_size || end % subregion_size) return false;
+
+    auto enabled = ((1u << (end / subregion_size)) - 1)
+                 & ~((1u << (start / subregion_size)) - 1);
+    l2_half_size_out = l2_half_size;
+    srd_out = uint8_t(~enabled);
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * Checks whether a key's brand disables any subregions.  Such a key conveys
+ * authority over only part of the Memory, so it can't be used to donate,
+ * split, or otherwise reshape the whole.
+ */
+static bool brand_disables_subregions(Brand const & brand) {
+  return Region::Rasr(uint32_t(brand) << 8).get_srd() != 0;
+}
+
+
+/*
+ * Loads a Memory's region into the MPU's kernel access region for the lifetime
+ * of this object, so that kernel accesses to it use the caching and ordering
+ * attributes from a key's brand.  The brand's access permissions are replaced
+ * with privileged-only access, since the kernel checks them itself, and its
+ * subregion disables are dropped.
+ *
+ * Unmappable Memory can't be described to the MPU, so it's accessed through
+ * the default memory map as before.
+ */
+class ScopedKernelAccess {
+public:
+  ScopedKernelAccess(Memory const & memory, Brand const & brand)
+    : _active{memory.is_mappable()} {
+    if (!_active) return;
+
+    using etl::armv7m::mpu;
+    auto region = memory.get_region_for_brand(brand);
+    mpu.write_rbar(region.rbar
+        .with_valid(true)
+        .with_region(config::kernel_access_region));
+    mpu.write_rasr(region.rasr
+        .with_ap(Mpu::AccessPermissions::p_write_u_none)
+        .with_xn(true)
+        .with_srd(memory.get_implicit_srd()));
+  }
+
+  ~ScopedKernelAccess() {
+    if (!_active) return;
+
+    using etl::armv7m::mpu;
+    mpu.write_rbar(Region::Rbar()
+        .with_valid(true)
+        .with_region(config::kernel_access_region));
+    mpu.write_rasr(Region::Rasr());
+  }
+
+private:
+  bool _active;
+};
+
+
 /*******************************************************************************
  * Construction, destruction, and basic properties.
  */
@@ -43,7 +145,7 @@ Memory::Memory(Generation g,
                size_t size,
                uint32_t attributes,
                Memory * parent)
-  : Object{g},
+  : Object{g, Kind::memory},
     _base{base},
     _size_bytes{size},
     _attributes{attributes},
@@ -52,22 +154,20 @@ Memory::Memory(Generation g,
 {
   PANIC_IF(base + size < base, "mem base+size overflow");
 
-  // Detect mappable regions at creation time and cache details.  Mappable
-  // regions are at least 32 bytes in size, are a power of two in size, and are
-  // naturally aligned with respect to their size.
-  if (_size_bytes >= 32
-      && (_size_bytes & (_size_bytes - 1)) == 0
-      && (_base & (_size_bytes - 1)) == 0) {
-    // Store this decision and cache the log2 of the size.
-    unsigned l2_half_size;
-    for (l2_half_size = 4; l2_half_size < 31; ++l2_half_size) {
-      if (_size_bytes == (2u << l2_half_size)) break;
-    }
-    _attributes = (_attributes & ~cached_l2hs_mask)
-                | (l2_half_size << cached_l2hs_lsb)
-                | mappable_attribute_mask;
-  } else {
-    _attributes = _attributes & ~(cached_l2hs_mask | mappable_attribute_mask);
+  // New objects start out unlocked, even if created from a locked parent.
+  _attributes &= ~lock_count_mask;
+
+  // Detect mappable regions at creation time and cache details.
+  _attributes &=
+    ~(cached_l2hs_mask | implicit_srd_mask | mappable_attribute_mask);
+
+  unsigned l2_half_size;
+  uint8_t srd;
+  if (find_covering_region(_base, _size_bytes, l2_half_size, srd)) {
+    // Store this decision and cache the region's shape.
+    _attributes |= (l2_half_size << cached_l2hs_lsb)
+                 | (uint32_t(srd) << implicit_srd_lsb)
+                 | mappable_attribute_mask;
   }
 
   if (parent) {
@@ -78,6 +178,9 @@ Memory::Memory(Generation g,
              "bad child geometry");
     ++parent->_child_count;
   }
+
+  // The Object constructor published our kind, but couldn't know our extent.
+  update_table_view(*this, _base, _size_bytes);
 }
 
 Memory::~Memory() {
@@ -96,11 +199,16 @@ Region Memory::get_region_for_brand(Brand const & brand) const {
     return { {}, {} };
   }
 
+  auto l2_half_size = get_cached_l2_half_size();
+  auto region_base = _base & ~((2u << l2_half_size) - 1);
+  auto rasr = Region::Rasr(uint32_t(brand) << 8);
+
   return {
     Region::Rbar()
-      .with_addr_27(_base >> 5),
-    Region::Rasr(uint32_t(brand) << 8)
-      .with_size(uint8_t(get_cached_l2_half_size()))
+      .with_addr_27(region_base >> 5),
+    rasr
+      .with_srd(uint8_t(rasr.get_srd() | get_implicit_srd()))
+      .with_size(uint8_t(l2_half_size))
       .with_enable(true),
   };
 }
@@ -109,9 +217,9 @@ void Memory::invalidation_hook() {
   // Invalidation leaves the hierarchy intact.  It is legal to invalidate an
   // object with children.
 
-  // We can't currently tell whether *this* Memory object is relevant for the
-  // MPU configuration, but invalidating the whole thing is pretty cheap.
-  current->apply_to_mpu();
+  // Any regions of the current Context that refer to this object must be
+  // unloaded; the keys are already stale.
+  current->apply_to_mpu_for(*this);
 }
 
 
@@ -155,6 +263,18 @@ static bool ap_is_stronger(Mpu::AccessPermissions a, Mpu::AccessPermissions b) {
   return da.priv > db.priv || da.unpriv > db.unpriv;
 }
 
+/*
+ * Checks whether a key's brand grants an access to the program using it.  Only
+ * mappable Memory has meaningful access permissions in its brand, so keys to
+ * other Memory grant everything.
+ */
+static bool brand_grants(bool mappable, Brand const & brand, Access access) {
+  if (!mappable) return true;
+
+  auto ap = Region::Rasr(uint32_t(brand) << 8).get_ap();
+  return !ap_is_unpredictable(ap) && decode_ap(ap).unpriv >= access;
+}
+
 /*
  * Lifts relevant and defined fields from a user-provided RASR value, leaving
  * undefined and irrelevant bits behind.
@@ -171,6 +291,26 @@ static constexpr Region::Rasr scrub_rasr(Region::Rasr dirty) {
 }
 
 
+/*
+ * Checks whether a Memory operation would move, reshape, or destroy the
+ * object, and so must be refused while it's locked.
+ */
+static bool disturbs_locked(Selector selector) {
+  namespace S = selector::memory;
+  switch (selector) {
+    case S::split:
+    case S::split_multiple:
+    case S::merge:
+    case S::become:
+    case S::become_array:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+
 /*******************************************************************************
  * Implementation of the Memory protocol.
  */
@@ -181,6 +321,11 @@ void Memory::deliver_from(Brand const & brand, Sender * sender) {
 
   ScopedReplySender reply_sender{k.keys[0]};
 
+  if (is_locked() && disturbs_locked(m.desc.get_selector())) {
+    reply_sender.message() = Message::failure(Exception::locked);
+    return;
+  }
+
   namespace S = selector::memory;
   switch (m.desc.get_selector()) {
     case S::inspect:
@@ -202,12 +347,14 @@ void Memory::deliver_from(Brand const & brand, Sender * sender) {
         }
 
         auto new_rasr = scrub_rasr(Region::Rasr(m.d0));
-        auto current_rasr = get_region_for_brand(brand).rasr;
+        // Compare against the brand, not the region, which also carries any
+        // implicit subregion disables.
+        auto current_rasr = Region::Rasr(uint32_t(brand) << 8);
 
         if (ap_is_unpredictable(new_rasr.get_ap())
             || ap_is_stronger(new_rasr.get_ap(), current_rasr.get_ap())
             || (current_rasr.get_srd() & ~new_rasr.get_srd())
-            || (_size_bytes < 256 && new_rasr.get_srd())) {
+            || (get_cached_l2_half_size() < 7 && new_rasr.get_srd())) {
           reply_sender.message() = Message::failure(Exception::bad_argument);
           return;
         }
@@ -221,8 +368,16 @@ void Memory::deliver_from(Brand const & brand, Sender * sender) {
       do_split(reply_sender, brand, m, k);
       return;
 
+    case S::split_multiple:
+      do_split_multiple(reply_sender, brand, m, k);
+      return;
+
+    case S::merge:
+      do_merge(reply_sender, brand, m, k);
+      return;
+
     case S::become:
-      if (get_region_for_brand(brand).rasr.get_srd()) {
+      if (brand_disables_subregions(brand)) {
         // Can't transmogrify, some subregions are disabled.
         reply_sender.message() = Message::failure(Exception::bad_operation);
         return;
@@ -231,39 +386,30 @@ void Memory::deliver_from(Brand const & brand, Sender * sender) {
       become(*this, m, k, reply_sender.rs);
       return;
 
+    case S::become_array:
+      if (brand_disables_subregions(brand)) {
+        reply_sender.message() = Message::failure(Exception::bad_operation);
+        return;
+      }
+
+      become_array(*this, brand, m, k, reply_sender.rs);
+      return;
+
     case S::peek:
     case S::poke:
-      {
-        auto offset = m.d0;
-        auto size_in_words = _size_bytes / sizeof(uint32_t);
-
-        if (offset >= size_in_words) {
-          reply_sender.message() = Message::failure(Exception::bad_argument);
-          return;
-        }
+    case S::peek_multiple:
+    case S::poke_multiple:
+      do_peek_poke(reply_sender, brand, m);
+      return;
 
-        // TODO: should use the caching/ordering specified by the key.  We can
-        // do this from kernel code by temporarily replacing one of the MPU
-        // regions with the one in the key.  Should be region #7 so it takes
-        // priority over potential aliases elsewhere in the MPU.
-
-        // Note: since the address is contained within the body of this Memory
-        // object, we do not need to use ldrt/strt to access it.  This is
-        // important!  ARMv7-M defines areas of address space, particularly
-        // the SysTick Timer, that are *inaccessible* to unprivileged code,
-        // even with MPU adjustments.  This fixes that.
-        auto ptr = reinterpret_cast<uint32_t *>(_base) + offset;
-        if (m.desc.get_selector() == S::peek) {
-          reply_sender.message().d0 = *ptr;
-        } else {  // poke
-          *ptr = m.d1;
-        }
-      }
+    case S::lock:
+    case S::unlock:
+      do_lock(reply_sender, brand, m);
       return;
 
     case S::make_child:
       {
-        if (get_region_for_brand(brand).rasr.get_srd()) {
+        if (brand_disables_subregions(brand)) {
           reply_sender.message() = Message::failure(Exception::bad_operation);
           return;
         }
@@ -281,6 +427,11 @@ void Memory::deliver_from(Brand const & brand, Sender * sender) {
           return;
         }
 
+        if (objptr->is_generation_near_wrap()) {
+          reply_sender.message() = Message::failure(Exception::causality);
+          return;
+        }
+
         auto slot_generation = objptr->get_generation();
         etl::destroy(*static_cast<Slot *>(objptr));
         auto child = new(objptr) Memory{slot_generation + 1,
@@ -311,7 +462,7 @@ void Memory::do_split(ScopedReplySender & reply_sender,
   }
 
   // We can't split if: subregions are disabled, or there are children.
-  if (get_region_for_brand(brand).rasr.get_srd()
+  if (brand_disables_subregions(brand)
       || child_count()) {
     reply_sender.message() = Message::failure(Exception::bad_operation);
     return;
@@ -327,6 +478,12 @@ void Memory::do_split(ScopedReplySender & reply_sender,
   // Note that, since slot indicates its Kind is slot, it does not alias
   // this.
 
+  // Both objects will have their generations advanced.
+  if (slot->is_generation_near_wrap() || is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+
   // Commit point
 
   // Rewrite the donated slot object.
@@ -361,8 +518,334 @@ void Memory::do_split(ScopedReplySender & reply_sender,
   }
 
   // Update MPU, in case the split object was in the current Context's memory
-  // map.
-  current->apply_to_mpu();
+  // map.  Only this object can be: keys to the donated Slot have been revoked,
+  // and a revoked key maps nothing, just as the Slot did.
+  current->apply_to_mpu_for(*this);
+}
+
+void Memory::do_split_multiple(ScopedReplySender & reply_sender,
+                               Brand const & brand,
+                               Message const & m,
+                               Keys & k) {
+  // Pieces after the first are made from Slots donated in k1 and up, so the
+  // number of message keys limits the number of pieces.
+  static constexpr unsigned max_pieces = config::n_message_keys;
+
+  auto count = m.d0;
+  if (count < 2 || count > max_pieces) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
+  // Work out the size of each piece.
+  size_t sizes[max_pieces];
+  if (m.d1 == 0) {
+    // Equal pieces.
+    if (_size_bytes % count) {
+      reply_sender.message() = Message::failure(Exception::bad_argument);
+      return;
+    }
+    for (unsigned i = 0; i < count; ++i) sizes[i] = _size_bytes / count;
+  } else {
+    // Caller-specified pieces, with the last taking the remainder.
+    uint32_t const given[max_pieces - 1] { m.d1, m.d2, m.d3 };
+    size_t left = _size_bytes;
+    for (unsigned i = 0; i < count - 1; ++i) {
+      if (given[i] > left) {
+        reply_sender.message() = Message::failure(Exception::bad_argument);
+        return;
+      }
+      sizes[i] = given[i];
+      left -= given[i];
+    }
+    sizes[count - 1] = left;
+  }
+
+  for (unsigned i = 0; i < count; ++i) {
+    if (sizes[i] == 0) {
+      reply_sender.message() = Message::failure(Exception::bad_argument);
+      return;
+    }
+  }
+
+  // We can't split if: subregions are disabled, or there are children.
+  if (brand_disables_subregions(brand)
+      || child_count()) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  // Check the donations.  As in do_split, an object claiming to be a Slot
+  // does not alias this, but the caller may have sent the same Slot twice.
+  Object * slots[max_pieces] {};
+  for (unsigned i = 1; i < count; ++i) {
+    slots[i] = k.keys[i].get();
+    if (slots[i]->get_kind() != Kind::slot) {
+      reply_sender.message() = Message::failure(Exception::bad_kind);
+      return;
+    }
+    for (unsigned j = 1; j < i; ++j) {
+      if (slots[j] == slots[i]) {
+        reply_sender.message() = Message::failure(Exception::bad_argument);
+        return;
+      }
+    }
+  }
+
+  // All objects will have their generations advanced.
+  if (is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+  for (unsigned i = 1; i < count; ++i) {
+    if (slots[i]->is_generation_near_wrap()) {
+      reply_sender.message() = Message::failure(Exception::causality);
+      return;
+    }
+  }
+
+  // Commit point
+
+  // Rewrite the donated slots, in address order after the first piece.
+  auto piece_base = _base + sizes[0];
+  for (unsigned i = 1; i < count; ++i) {
+    auto generation = slots[i]->get_generation();
+    etl::destroy(*static_cast<Slot *>(slots[i]));
+    auto piece = new(slots[i]) Memory{
+        generation + 1,
+        piece_base,
+        sizes[i],
+        _attributes};
+    reply_sender.set_key(i, piece->make_key(brand).ref());
+    piece_base += sizes[i];
+  }
+
+  // Rewrite this object to become the first piece.  Its key goes in k0, since
+  // the other keys correspond to the donated Slots.
+  {
+    auto generation = get_generation();
+    auto base = _base;
+    auto atts = _attributes;
+    etl::destroy(*this);
+    auto first = new(this) Memory{generation + 1, base, sizes[0], atts};
+    reply_sender.set_key(0, first->make_key(brand).ref());
+  }
+
+  // Update MPU, as in do_split.
+  current->apply_to_mpu_for(*this);
+}
+
+void Memory::do_merge(ScopedReplySender & reply_sender,
+                      Brand const & brand,
+                      Message const &,
+                      Keys & k) {
+  auto & upper_key = k.keys[1];
+  auto upper_obj = upper_key.get();
+  if (upper_obj->get_kind() != Kind::memory) {
+    reply_sender.message() = Message::failure(Exception::bad_kind);
+    return;
+  }
+  auto & upper = *static_cast<Memory *>(upper_obj);
+
+  // The upper object must begin where this one ends.
+  if (&upper == this || upper._base != _base + _size_bytes) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
+  // The merged object will be reachable through a key with this brand, so the
+  // caller must hold the same authority over both pieces.
+  if (upper_key.get_brand() != brand) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
+  // We can't merge if: subregions are disabled, either object takes part in
+  // a hierarchy, or their attributes differ.
+  if (brand_disables_subregions(brand)
+      || child_count() || upper.child_count()
+      || !is_top() || !upper.is_top()
+      || is_device() != upper.is_device()) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  // This object was checked on entry, but the upper one must be unlocked too.
+  if (upper.is_locked()) {
+    reply_sender.message() = Message::failure(Exception::locked);
+    return;
+  }
+
+  // Both objects will have their generations advanced.
+  if (is_generation_near_wrap() || upper.is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+
+  // Commit point
+
+  auto upper_size = upper._size_bytes;
+
+  // Turn the upper object back into a Slot, revoking keys to it.
+  Slot * slot;
+  {
+    auto generation = upper.get_generation();
+    etl::destroy(upper);
+    slot = new(&upper) Slot{generation + 1};
+  }
+
+  // Rewrite this object to cover both.
+  {
+    auto generation = get_generation();
+    auto base = _base;
+    auto size = _size_bytes + upper_size;
+    auto atts = _attributes;
+    etl::destroy(*this);
+    auto merged = new(this) Memory{generation + 1, base, size, atts};
+    reply_sender.set_key(1, merged->make_key(brand).ref());
+  }
+
+  // Give the Slot back to the system, unless it has worn out (as with
+  // ObjectTable's free_slot).
+  if (slot->is_generation_near_wrap()) {
+    reply_sender.message().d0 = 1;
+  } else {
+    object_table().add_free_slot(*slot);
+  }
+
+  // Update MPU, in case either piece was in the current Context's memory map.
+  current->apply_to_mpu_for(*this);
+  current->apply_to_mpu_for(*slot);
+}
+
+void Memory::do_peek_poke(ScopedReplySender & reply_sender,
+                          Brand const & brand,
+                          Message const & m) {
+  namespace S = selector::memory;
+
+  // Layout of d1 in the multiple forms.
+  static constexpr uint32_t
+    count_mask = 0xFF,
+    fixed_bit = 1u << 8;
+  // Limits on count, set by the number of data words in a Message.
+  static constexpr unsigned
+    max_peek_words = 5,
+    max_poke_words = 3;
+
+  auto selector = m.desc.get_selector();
+  bool multiple = selector == S::peek_multiple
+               || selector == S::poke_multiple;
+  bool write = selector == S::poke || selector == S::poke_multiple;
+
+  auto offset = m.d0;
+  unsigned count = 1;
+  bool fixed = false;
+  if (multiple) {
+    count = m.d1 & count_mask;
+    fixed = m.d1 & fixed_bit;
+  }
+
+  auto size_in_words = _size_bytes / sizeof(uint32_t);
+  auto span = fixed ? 1 : count;
+  if (count == 0
+      || count > (write ? max_poke_words : max_peek_words)
+      || offset >= size_in_words
+      || span > size_in_words - offset) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
+  // The key must grant the access to the program using it.
+  if (!brand_grants(is_mappable(), brand,
+                    write ? Access::write : Access::read)) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  uint32_t const words_in[max_poke_words] {
+    multiple ? m.d2 : m.d1,
+    m.d3,
+    m.d4,
+  };
+  uint32_t words_out[max_peek_words] {};
+
+  // Note: since the address is contained within the body of this Memory
+  // object, we do not need to use ldrt/strt to access it.  This is
+  // important!  ARMv7-M defines areas of address space, particularly
+  // the SysTick Timer, that are *inaccessible* to unprivileged code,
+  // even with MPU adjustments.  This fixes that.
+  //
+  // The accesses are volatile, so that each happens exactly once and in
+  // order, as a device register (e.g. a FIFO accessed with 'fixed') expects.
+  auto ptr = reinterpret_cast<uint32_t volatile *>(_base) + offset;
+  {
+    ScopedKernelAccess access{*this, brand};
+    for (unsigned i = 0; i < count; ++i) {
+      if (write) {
+        *ptr = words_in[i];
+      } else {
+        words_out[i] = *ptr;
+      }
+      if (!fixed) ++ptr;
+    }
+  }
+
+  if (!write) {
+    auto & r = reply_sender.message();
+    r.d0 = words_out[0];
+    r.d1 = words_out[1];
+    r.d2 = words_out[2];
+    r.d3 = words_out[3];
+    r.d4 = words_out[4];
+  }
+}
+
+void Memory::do_lock(ScopedReplySender & reply_sender,
+                     Brand const & brand,
+                     Message const & m) {
+  // Locking can stall the owner's allocator, and unlocking can pull a buffer
+  // out from under a DMA transfer, so both take full authority over the
+  // Memory: a key that covers all of it, and could write all of it.
+  if (brand_disables_subregions(brand)
+      || !brand_grants(is_mappable(), brand, Access::write)) {
+    reply_sender.message() = Message::failure(Exception::bad_operation);
+    return;
+  }
+
+  if (m.desc.get_selector() == selector::memory::lock) {
+    if (!lock()) {
+      // The count would overflow.
+      reply_sender.message() = Message::failure(Exception::bad_operation);
+      return;
+    }
+  } else {  // unlock
+    // The last lock on the Object Table view belongs to the kernel, which is
+    // still writing to it.
+    if (!is_locked()
+        || (get_lock_count() == 1 && object_table().is_view(*this))) {
+      reply_sender.message() = Message::failure(Exception::bad_operation);
+      return;
+    }
+    unlock();
+  }
+
+  reply_sender.message().d0 = get_lock_count();
+}
+
+bool Memory::lock() {
+  auto count = get_lock_count();
+  if (count == (lock_count_mask >> lock_count_lsb)) return false;
+  set_lock_count(count + 1);
+  return true;
+}
+
+void Memory::unlock() {
+  PANIC_UNLESS(is_locked(), "unlocking unlocked Memory");
+  set_lock_count(get_lock_count() - 1);
+}
+
+void Memory::set_lock_count(unsigned count) {
+  _attributes = (_attributes & ~lock_count_mask) | (count << lock_count_lsb);
 }
 
 }  // namespace k
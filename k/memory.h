@@ -10,12 +10,16 @@
  * same as normal memory in nearly all circumstances, but *cannot* be donated
  * to the kernel using Become.
  *
- * Memory objects fulfilling certain restrictions (power of two in size,
- * naturally aligned, 32 bytes or larger) are "mappable," meaning they can be
- * loaded into the MPU to allow a program direct access to address space.
+ * Memory objects that can be described by a single MPU region are
+ * "mappable," meaning they can be loaded into the MPU to allow a program
+ * direct access to address space.  This includes Memory that is a power of
+ * two in size, naturally aligned, and 32 bytes or larger, but also Memory
+ * that exactly covers some contiguous subregions of such a region (256 bytes
+ * or larger); the remaining subregions are disabled whenever it's loaded.
  */
 
 #include <cstddef>
+#include <cstdint>
 
 #include "k/key.h"
 #include "k/object.h"
@@ -43,7 +47,16 @@ public:
     // Bit offset to cached log2(half size) for mappable memory.
     cached_l2hs_lsb = 8,
     // Mask for cached log2(half size).
-    cached_l2hs_mask = 0x1F << cached_l2hs_lsb;
+    cached_l2hs_mask = 0x1F << cached_l2hs_lsb,
+    // Bit offset to cached subregion disable bits for mappable memory that
+    // covers only part of its region.
+    implicit_srd_lsb = 16,
+    // Mask for cached subregion disable bits.
+    implicit_srd_mask = 0xFF << implicit_srd_lsb,
+    // Bit offset to the lock count.
+    lock_count_lsb = 24,
+    // Mask for the lock count.
+    lock_count_mask = 0xFFu << lock_count_lsb;
 
   /*
    * Creates a Memory object of a certain Generation.
@@ -86,6 +99,11 @@ public:
    */
   bool is_device() const { return _attributes & device_attribute_mask; }
 
+  /*
+   * Gets the attributes word, e.g. to carry it over to a replacement object.
+   */
+  uint32_t get_attributes() const { return _attributes; }
+
   /*
    * Checks whether this Memory has the "mappable" attribute set.
    */
@@ -99,6 +117,42 @@ public:
     return (_attributes & cached_l2hs_mask) >> cached_l2hs_lsb;
   }
 
+  /*
+   * For mappable Memory, retrieves the subregion disable bits needed to
+   * restrict its region to this object's extent, computed at creation.  For
+   * other Memory, the result is undefined.
+   */
+  uint8_t get_implicit_srd() const {
+    return uint8_t((_attributes & implicit_srd_mask) >> implicit_srd_lsb);
+  }
+
+  /*
+   * Retrieves the number of outstanding locks on this Memory.  While it's
+   * non-zero, the Memory can't be split, merged, donated to the kernel, or
+   * invalidated, so that e.g. a DMA transfer into it can't be disturbed.
+   */
+  unsigned get_lock_count() const {
+    return (_attributes & lock_count_mask) >> lock_count_lsb;
+  }
+
+  bool is_locked() const {
+    return get_lock_count() != 0;
+  }
+
+  /*
+   * Adds a lock on behalf of the kernel, e.g. while it's using the Memory's
+   * contents.  Returns false, changing nothing, if the count is at its
+   * maximum.
+   */
+  bool lock();
+
+  /*
+   * Removes a lock added by lock().
+   *
+   * Precondition: is_locked().
+   */
+  void unlock();
+
   /*
    * Checks whether this Memory is "top," i.e. has no parent.
    */
@@ -131,7 +185,6 @@ public:
   Region get_region_for_brand(Brand const &) const override;
 
   void deliver_from(Brand const &, Sender *) override;
-  Kind get_kind() const override { return Kind::memory; }
 
 private:
   uintptr_t _base;
@@ -143,6 +196,13 @@ private:
   uint32_t _child_count;
 
   void do_split(ScopedReplySender &, Brand const &, Message const &, Keys &);
+  void do_split_multiple(ScopedReplySender &, Brand const &, Message const &,
+                         Keys &);
+  void do_merge(ScopedReplySender &, Brand const &, Message const &, Keys &);
+  void do_peek_poke(ScopedReplySender &, Brand const &, Message const &);
+  void do_lock(ScopedReplySender &, Brand const &, Message const &);
+
+  void set_lock_count(unsigned);
 
   void invalidation_hook() override;
 };
@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
 #include <cstdlib>
 
+#include "etl/destroy.h"
 #include "etl/armv7m/mpu.h"
 
 #include "common/abi_sizes.h"
+#include "common/selectors.h"
 
 #include "k/context.h"
 #include "k/gate.h"
@@ -33,7 +35,8 @@ protected:
   ObjectTable::Entry _entries[5];
 
   Context::Body _fake_context_body;
-  Context _fake_context{0, _fake_context_body};
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
 
   Spy _spy{0, Object::Kind::context};
   ReplySender _sender;
@@ -193,6 +196,72 @@ TEST(MemoryTest, construct_bad_child) {
   ASSERT_EQ(parent.child_count(), 0);
 }
 
+/*
+ * Memory that isn't a naturally aligned power of two can still be mapped if it
+ * covers whole subregions of some region.
+ */
+
+TEST(MemoryTest, ctor_subregions_from_bottom) {
+  // Five eighths of a 2 KiB region.
+  Memory m{0, 0x1000, 0x500, 0};
+  ASSERT_TRUE(m.is_mappable());
+  ASSERT_EQ(10, m.get_cached_l2_half_size());
+  ASSERT_EQ(0xE0, m.get_implicit_srd());
+
+  auto region = m.get_region_for_brand(0);
+  ASSERT_EQ(0x1000u, region.rbar.get_addr_27() << 5);
+  ASSERT_EQ(10, region.rasr.get_size());
+  ASSERT_EQ(0xE0, region.rasr.get_srd());
+}
+
+TEST(MemoryTest, ctor_subregions_in_middle) {
+  // Three eighths of a 1 KiB region, starting at the third.
+  Memory m{0, 0x1100, 0x300, 0};
+  ASSERT_TRUE(m.is_mappable());
+  ASSERT_EQ(9, m.get_cached_l2_half_size());
+  ASSERT_EQ(0x03, m.get_implicit_srd());
+
+  auto region = m.get_region_for_brand(0);
+  ASSERT_EQ(0x1000u, region.rbar.get_addr_27() << 5)
+    << "region should be based at the covering region, not the object";
+}
+
+TEST(MemoryTest, ctor_subregions_misaligned) {
+  // Covered by a 1 KiB region, but doesn't end on a subregion boundary.
+  Memory m{0, 0x1000, 0x340, 0};
+  ASSERT_FALSE(m.is_mappable());
+}
+
+TEST(MemoryTest, ctor_subregions_small) {
+  // Regions smaller than 256 bytes have no subregions, so this must use a
+  // larger region than it otherwise would.
+  Memory m{0, 0x1000, 0x60, 0};
+  ASSERT_TRUE(m.is_mappable());
+  ASSERT_EQ(7, m.get_cached_l2_half_size());
+  ASSERT_EQ(0xF8, m.get_implicit_srd());
+}
+
+TEST(MemoryTest, region_contains_only_enabled_subregions) {
+  Memory m{0, 0x1100, 0x300, 0};
+  auto region = m.get_region_for_brand(0);
+
+  ASSERT_FALSE(region.contains(0x10FF));
+  ASSERT_TRUE(region.contains(0x1100));
+  ASSERT_TRUE(region.contains(0x13FF));
+  ASSERT_FALSE(region.contains(0x1400));
+  ASSERT_FALSE(region.contains(0x1000))
+    << "disabled subregions of the covering region must not count";
+}
+
+TEST(MemoryTest, ctor_subregions_combine_with_brand) {
+  Memory m{0, 0x1000, 0x500, 0};
+  auto brand = Brand(uint32_t(Rasr().with_srd(0x01)) >> 8);
+
+  auto region = m.get_region_for_brand(brand);
+  ASSERT_EQ(0xE1, region.rasr.get_srd())
+    << "brand's subregion disables should add to the implicit ones";
+}
+
 
 
 
@@ -391,6 +460,381 @@ TEST_F(MemoryTest_Typical, split_ok) {
   ASSERT_RETURNED_KEY_SHAPE(newmem, brand_from_rasr(rw_rasr), 2);
 }
 
+/*
+ * MPU maintenance.  Changes to a Memory object should only touch the MPU if
+ * the current Context has it mapped, and then only the affected regions.  The
+ * fake MPU holds the last values written, so we seed it with a recognizable
+ * pattern to tell whether anything was written.
+ */
+
+static constexpr uint32_t mpu_poison = 0xDEADBEE0;
+
+static void poison_mpu() {
+  etl::armv7m::mpu.write_rbar(Rbar(mpu_poison));
+  etl::armv7m::mpu.write_rasr(Rasr(mpu_poison));
+}
+
+TEST_F(MemoryTest_Typical, split_unmapped_leaves_mpu) {
+  poison_mpu();
+
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split, 0),
+      128,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(mpu_poison, uint32_t(etl::armv7m::mpu.read_rbar()))
+    << "MPU should not be touched when the Memory isn't mapped";
+  ASSERT_EQ(mpu_poison, uint32_t(etl::armv7m::mpu.read_rasr()));
+}
+
+TEST_F(MemoryTest_Typical, split_mapped_unloads_region) {
+  static constexpr unsigned region = 2;
+  _fake_context.memory_region(region) =
+    memory().make_key(brand_from_rasr(rw_rasr)).ref();
+  poison_mpu();
+
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split, 0),
+      128,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  auto rbar = etl::armv7m::mpu.read_rbar();
+  ASSERT_TRUE(rbar.get_valid());
+  ASSERT_EQ(region, rbar.get_region())
+    << "only the region mapping the split Memory should be loaded";
+  ASSERT_FALSE(etl::armv7m::mpu.read_rasr().get_enable())
+    << "region key was revoked, so the region should be disabled";
+  ASSERT_TRUE(etl::armv7m::mpu.read_ctrl().get_enable());
+  ASSERT_NULL_KEY(_fake_context.memory_region(region));
+}
+
+TEST_F(MemoryTest_Typical, invalidate_mapped_unloads_region) {
+  static constexpr unsigned region = 0;
+  _fake_context.memory_region(region) =
+    memory().make_key(brand_from_rasr(rw_rasr)).ref();
+  poison_mpu();
+
+  memory().invalidate();
+
+  ASSERT_EQ(region, etl::armv7m::mpu.read_rbar().get_region());
+  ASSERT_FALSE(etl::armv7m::mpu.read_rasr().get_enable())
+    << "invalidated Memory must not remain mapped";
+  ASSERT_NULL_KEY(_fake_context.memory_region(region));
+}
+
+/*
+ * Split Multiple
+ */
+
+TEST_F(MemoryTest_Typical, split_multiple_ok) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  _sender.set_key(2, slot2().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      3,
+      64,
+      64,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(1, memory().get_generation());
+  ASSERT_EQ(uut_base(), memory().get_base());
+  ASSERT_EQ(64, memory().get_size());
+
+  auto & second = static_cast<Memory &>(slot());
+  ASSERT_EQ(Object::Kind::memory, second.get_kind());
+  ASSERT_EQ(uut_base() + 64, second.get_base());
+  ASSERT_EQ(64, second.get_size());
+
+  auto & third = static_cast<Memory &>(slot2());
+  ASSERT_EQ(Object::Kind::memory, third.get_kind());
+  ASSERT_EQ(uut_base() + 128, third.get_base());
+  ASSERT_EQ(128, third.get_size()) << "last piece should take the remainder";
+
+  ASSERT_RETURNED_KEY_SHAPE(memory(), brand_from_rasr(rw_rasr), 0);
+  ASSERT_RETURNED_KEY_SHAPE(second, brand_from_rasr(rw_rasr), 1);
+  ASSERT_RETURNED_KEY_SHAPE(third, brand_from_rasr(rw_rasr), 2);
+  ASSERT_RETURNED_KEY_NULL(3);
+}
+
+TEST_F(MemoryTest_Typical, split_multiple_equal) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      2,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(128, memory().get_size());
+  ASSERT_EQ(uut_base() + 128, static_cast<Memory &>(slot()).get_base());
+}
+
+TEST_F(MemoryTest_Typical, split_multiple_unequal_division) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  _sender.set_key(2, slot2().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      3,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Typical, split_multiple_too_big) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      2,
+      256,
+      });
+
+  // The last piece would be empty.
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Typical, split_multiple_same_slot_twice) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  _sender.set_key(2, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      3,
+      64,
+      64,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind());
+  ASSERT_EQ(0, memory().get_generation());
+}
+
+TEST_F(MemoryTest_Typical, split_multiple_not_slot) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split_multiple, 0),
+      3,
+      64,
+      64,
+      });
+
+  // k2 was not donated.
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_kind);
+}
+
+/*
+ * Merge
+ */
+
+class MemoryTest_Merge : public MemoryTest_Typical {
+protected:
+  Memory & upper() {
+    return static_cast<Memory &>(slot());
+  }
+
+  void SetUp() override {
+    MemoryTest_Typical::SetUp();
+    new(&slot()) Memory{0, uut_base() + uut_size(), 128, 0};
+  }
+
+  Message const & send_merge(Rasr rasr, Rasr upper_rasr) {
+    _sender.set_key(1, upper().make_key(brand_from_rasr(upper_rasr)).ref());
+    return send_from_spy(rasr, {
+        Descriptor::call(selector::memory::merge, 0),
+        });
+  }
+};
+
+TEST_F(MemoryTest_Merge, ok) {
+  auto & m = send_merge(rw_rasr, rw_rasr);
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(1, memory().get_generation());
+  ASSERT_EQ(uut_base(), memory().get_base());
+  ASSERT_EQ(uut_size() + 128, memory().get_size());
+  ASSERT_RETURNED_KEY_SHAPE(memory(), brand_from_rasr(rw_rasr), 1);
+
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind());
+  ASSERT_EQ(1, slot().get_generation());
+  ASSERT_TRUE(static_cast<Slot &>(slot()).is_free())
+    << "freed slot should be available to alloc_slot";
+}
+
+TEST_F(MemoryTest_Merge, not_adjacent) {
+  new(&slot()) Memory{0, uut_base() + uut_size() + 32, 128, 0};
+  auto & m = send_merge(rw_rasr, rw_rasr);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Merge, wrong_order) {
+  _sender.set_key(1, memory().make_key(brand_from_rasr(rw_rasr)).ref());
+  _sender.message() = {Descriptor::call(selector::memory::merge, 0)};
+  _sender.set_key(0, _spy.make_key(0).ref());
+  upper().deliver_from(brand_from_rasr(rw_rasr), &_sender);
+
+  ASSERT_RETURNED_EXCEPTION(_spy.message().m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Merge, self) {
+  _sender.set_key(1, memory().make_key(brand_from_rasr(rw_rasr)).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::merge, 0),
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Merge, brand_mismatch) {
+  auto ro_rasr = Rasr().with_ap(Mpu::AccessPermissions::p_read_u_read);
+  auto & m = send_merge(rw_rasr, ro_rasr);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_Merge, device_mismatch) {
+  upper().mark_as_device();
+  auto & m = send_merge(rw_rasr, rw_rasr);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+}
+
+TEST_F(MemoryTest_Merge, parent_must_fail) {
+  new(&slot2()) Memory{0, uut_base(), 64, 0, &memory()};
+  auto & m = send_merge(rw_rasr, rw_rasr);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+}
+
+TEST_F(MemoryTest_Merge, not_memory) {
+  _sender.set_key(1, slot2().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::merge, 0),
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_kind);
+}
+
+TEST_F(MemoryTest_Merge, upper_locked) {
+  Spy lock_spy{0, Object::Kind::context};
+  ReplySender sender{{Descriptor::call(selector::memory::lock, 0)}};
+  sender.set_key(0, lock_spy.make_key(0).ref());
+  upper().deliver_from(brand_from_rasr(rw_rasr), &sender);
+  ASSERT_TRUE(upper().is_locked());
+
+  auto & m = send_merge(rw_rasr, rw_rasr);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::locked);
+}
+
+/*
+ * Lock and Unlock.  These tests lock the Memory through a separate Spy, so
+ * that the operation under test is the only one sent from _spy.
+ */
+
+class MemoryTest_Lock : public MemoryTest_Typical {
+protected:
+  Spy _lock_spy{0, Object::Kind::context};
+
+  Message const & send_lock(Selector selector) {
+    ReplySender sender{{Descriptor::call(selector, 0)}};
+    sender.set_key(0, _lock_spy.make_key(0).ref());
+    memory().deliver_from(brand_from_rasr(rw_rasr), &sender);
+    return _lock_spy.message().m;
+  }
+};
+
+TEST_F(MemoryTest_Lock, counts) {
+  ASSERT_FALSE(memory().is_locked());
+
+  ASSERT_EQ(1u, send_lock(selector::memory::lock).d0);
+  ASSERT_EQ(2u, send_lock(selector::memory::lock).d0);
+  ASSERT_EQ(1u, send_lock(selector::memory::unlock).d0);
+  ASSERT_TRUE(memory().is_locked()) << "locks should nest";
+
+  ASSERT_EQ(0u, send_lock(selector::memory::unlock).d0);
+  ASSERT_FALSE(memory().is_locked());
+}
+
+TEST_F(MemoryTest_Lock, unlock_unlocked) {
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::unlock, 0),
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+}
+
+TEST_F(MemoryTest_Lock, split_locked) {
+  send_lock(selector::memory::lock);
+
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split, 0),
+      128,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::locked);
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind())
+    << "donated Slot must not be consumed";
+  ASSERT_EQ(0, memory().get_generation());
+}
+
+TEST_F(MemoryTest_Lock, become_locked) {
+  send_lock(selector::memory::lock);
+
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::become, 0),
+      1,  // Gate
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::locked);
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+}
+
+TEST_F(MemoryTest_Lock, split_after_unlock) {
+  send_lock(selector::memory::lock);
+  send_lock(selector::memory::unlock);
+
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::split, 0),
+      128,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+}
+
+TEST_F(MemoryTest_Lock, inspect_locked) {
+  send_lock(selector::memory::lock);
+
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::inspect, 0),
+      });
+  ASSERT_MESSAGE_SUCCESS(m) << "locking only prevents disturbing the Memory";
+}
+
+TEST_F(MemoryTest_Lock, read_only_key_cannot_lock) {
+  auto ro_rasr = Rasr().with_ap(Mpu::AccessPermissions::p_write_u_read);
+  auto & m = send_from_spy(ro_rasr, {
+      Descriptor::call(selector::memory::lock, 0),
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_FALSE(memory().is_locked());
+}
+
+TEST_F(MemoryTest_Lock, restricted_key_cannot_unlock) {
+  send_lock(selector::memory::lock);
+
+  auto & m = send_from_spy(rw_rasr.with_srd(1), {
+      Descriptor::call(selector::memory::unlock, 0),
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_TRUE(memory().is_locked())
+    << "a key covering part of the Memory must not release a lock";
+}
+
+TEST_F(MemoryTest_Lock, child_starts_unlocked) {
+  send_lock(selector::memory::lock);
+
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::make_child, 0),
+      uut_base(),
+      128,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_FALSE(static_cast<Memory &>(slot()).is_locked());
+}
+
 /*
  * Make Child
  */
@@ -479,6 +923,118 @@ TEST_F(MemoryTest_Typical, make_child_ok) {
   ASSERT_RETURNED_KEY_SHAPE(slot(), brand_from_rasr(rw_rasr), 1);
 }
 
+/*******************************************************************************
+ * Peek and Poke, which actually touch memory, and so need a real buffer.  It's
+ * static so that its alignment -- needed for it to be mappable -- is honored.
+ */
+
+alignas(256) static uint32_t peek_poke_buffer[64];
+
+class MemoryTest_PeekPoke : public MemoryTest {
+protected:
+  uintptr_t uut_base() override {
+    return reinterpret_cast<uintptr_t>(peek_poke_buffer);
+  }
+  size_t uut_size() override {
+    return sizeof(peek_poke_buffer);
+  }
+
+  void SetUp() override {
+    MemoryTest::SetUp();
+    for (unsigned i = 0; i < 64; ++i) peek_poke_buffer[i] = 0x100 + i;
+  }
+};
+
+TEST_F(MemoryTest_PeekPoke, peek_multiple_ok) {
+  ASSERT_TRUE(memory().is_mappable());
+
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::peek_multiple, 0),
+      2,
+      5,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0x102u, m.d0);
+  ASSERT_EQ(0x103u, m.d1);
+  ASSERT_EQ(0x104u, m.d2);
+  ASSERT_EQ(0x105u, m.d3);
+  ASSERT_EQ(0x106u, m.d4);
+
+  ASSERT_EQ(config::kernel_access_region,
+            etl::armv7m::mpu.read_rbar().get_region());
+  ASSERT_FALSE(etl::armv7m::mpu.read_rasr().get_enable())
+    << "kernel access region must be unloaded afterwards";
+}
+
+TEST_F(MemoryTest_PeekPoke, poke_multiple_ok) {
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::poke_multiple, 0),
+      61,
+      3,
+      0xA,
+      0xB,
+      0xC,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0xAu, peek_poke_buffer[61]);
+  ASSERT_EQ(0xBu, peek_poke_buffer[62]);
+  ASSERT_EQ(0xCu, peek_poke_buffer[63]);
+}
+
+TEST_F(MemoryTest_PeekPoke, poke_multiple_fixed) {
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::poke_multiple, 0),
+      63,
+      3 | (1 << 8),
+      0xA,
+      0xB,
+      0xC,
+      });
+  ASSERT_MESSAGE_SUCCESS(m)
+    << "fixed transfers need only one word of room";
+  ASSERT_EQ(0xCu, peek_poke_buffer[63]) << "last word should win";
+  ASSERT_EQ(0x13Eu, peek_poke_buffer[62]);
+}
+
+TEST_F(MemoryTest_PeekPoke, poke_multiple_too_many) {
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::poke_multiple, 0),
+      0,
+      4,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_PeekPoke, peek_multiple_past_end) {
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::peek_multiple, 0),
+      62,
+      3,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+}
+
+TEST_F(MemoryTest_PeekPoke, poke_read_only) {
+  auto ro_rasr = Rasr().with_ap(Mpu::AccessPermissions::p_write_u_read);
+  auto & m = send_from_spy(ro_rasr, {
+      Descriptor::call(selector::memory::poke, 0),
+      0,
+      0xA,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_EQ(0x100u, peek_poke_buffer[0]);
+}
+
+TEST_F(MemoryTest_PeekPoke, peek_read_only) {
+  auto ro_rasr = Rasr().with_ap(Mpu::AccessPermissions::p_write_u_read);
+  auto & m = send_from_spy(ro_rasr, {
+      Descriptor::call(selector::memory::peek, 0),
+      1,
+      });
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(0x101u, m.d0);
+}
+
 /*******************************************************************************
  * Tests at the 128-byte level, where subregions stop working.
  */
@@ -619,6 +1175,219 @@ TEST_F(MemoryTest_BecomeInterrupt, ok) {
     << "interrupt should have wired itself into the table";
 }
 
+/*
+ * Become requires only that the base be aligned to 8 bytes, so that bodies can
+ * be carved to size instead of rounded up to a mappable power of two.
+ */
+template <uintptr_t Offset>
+class MemoryTest_BecomeCarved : public MemoryTest {
+protected:
+  alignas(8) uint8_t _buffer[kabi::context_size + 8];
+
+  uintptr_t uut_base() override {
+    return reinterpret_cast<uintptr_t>(_buffer) + Offset;
+  }
+  size_t uut_size() override { return kabi::context_size; }
+
+  Message const & send_become(unsigned tc) {
+    return send_from_spy(rw_rasr, {
+        Descriptor::call(selector::memory::become, 0),
+        tc,
+        });
+  }
+};
+
+using MemoryTest_BecomeCarvedAligned = MemoryTest_BecomeCarved<8>;
+TEST_F(MemoryTest_BecomeCarvedAligned, context_ok) {
+  ASSERT_FALSE(memory().is_mappable());
+
+  auto & m = send_become(0);
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Object::Kind::context, object().get_kind());
+  ASSERT_RETURNED_KEY_SHAPE(object(), 0, 1);
+}
+
+TEST_F(MemoryTest_BecomeCarvedAligned, context_destroy) {
+  ASSERT_MESSAGE_SUCCESS(send_become(0));
+  Key ctx_key = _spy.keys().keys[1];
+
+  _sender.message() = {Descriptor::call(selector::context::destroy, 0)};
+  _sender.set_key(0, _spy.make_key(0).ref());
+  object().deliver_from(0, &_sender);
+  ASSERT_EQ(2, _spy.count()) << "single reply should be sent";
+
+  auto & m = _spy.message().m;
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(2, object().get_generation());
+  ASSERT_EQ(uut_base(), memory().get_base());
+  ASSERT_EQ(uut_size(), memory().get_size());
+  ASSERT_RETURNED_KEY_SHAPE(object(), 0, 1);
+  ASSERT_NULL_KEY(ctx_key) << "keys to the Context must be revoked";
+}
+
+using MemoryTest_BecomeCarvedMisaligned = MemoryTest_BecomeCarved<4>;
+TEST_F(MemoryTest_BecomeCarvedMisaligned, context_fail) {
+  auto & m = send_become(0);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+}
+
+/*
+ * Keyrings use all the memory they're given, up to a configured number of keys.
+ */
+template <unsigned Count>
+class MemoryTest_BecomeKeyring : public MemoryTest {
+protected:
+  alignas(8) uint8_t _buffer[Count * sizeof(Key)];
+
+  uintptr_t uut_base() override {
+    return reinterpret_cast<uintptr_t>(_buffer);
+  }
+  size_t uut_size() override { return sizeof(_buffer); }
+
+  Message const & send_become() {
+    return send_from_spy(rw_rasr, {
+        Descriptor::call(selector::memory::become, 0),
+        4,
+        });
+  }
+};
+
+using MemoryTest_BecomeKeyringMax =
+  MemoryTest_BecomeKeyring<config::max_keyring_keys>;
+TEST_F(MemoryTest_BecomeKeyringMax, ok) {
+  auto & m = send_become();
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  ASSERT_EQ(Object::Kind::keyring, object().get_kind());
+  ASSERT_RETURNED_KEY_SHAPE(object(), 0, 1);
+}
+
+using MemoryTest_BecomeKeyringTooBig =
+  MemoryTest_BecomeKeyring<config::max_keyring_keys + 1>;
+TEST_F(MemoryTest_BecomeKeyringTooBig, fail) {
+  auto & m = send_become();
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(0, object().get_generation());
+}
+
+TEST_F(MemoryTest_BecomeKeyringTooBig, array_fail) {
+  _sender.set_key(1, slot().make_key(0).ref());
+  auto & m = send_from_spy(rw_rasr, {
+      Descriptor::call(selector::memory::become_array, 0),
+      4,
+      1,
+      });
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind());
+}
+
+/*******************************************************************************
+ * Become Array.
+ */
+
+class MemoryTest_BecomeArray : public MemoryTest {
+protected:
+  // Gate bodies, rounded up to the kernel's body alignment.
+  static constexpr size_t gate_body_size = (kabi::gate_size + 7) & ~7u;
+
+  alignas(8) uint8_t _buffer[gate_body_size * 3];
+
+  uintptr_t uut_base() override {
+    return reinterpret_cast<uintptr_t>(_buffer);
+  }
+  size_t uut_size() override { return sizeof(_buffer); }
+
+  // By default, the Slot key's brand covers exactly the requested Slots.
+  Message const & send_become_array(unsigned tc, unsigned count,
+                                    Object & first) {
+    return send_become_array(tc, count, first, count - 1);
+  }
+
+  Message const & send_become_array(unsigned tc, unsigned count,
+                                    Object & first, Brand span) {
+    _sender.set_key(1, first.make_key(span).ref());
+    return send_from_spy(rw_rasr, {
+        Descriptor::call(selector::memory::become_array, 0),
+        tc,
+        count,
+        });
+  }
+};
+
+constexpr size_t MemoryTest_BecomeArray::gate_body_size;
+
+TEST_F(MemoryTest_BecomeArray, gates_ok) {
+  auto & m = send_become_array(1, 2, slot());
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(2, m.d0);
+
+  ASSERT_EQ(Object::Kind::gate, slot().get_kind());
+  ASSERT_EQ(Object::Kind::gate, slot2().get_kind());
+  ASSERT_EQ(1, slot().get_generation());
+  ASSERT_EQ(1, slot2().get_generation());
+  ASSERT_RETURNED_KEY_SHAPE(slot(), 0, 1);
+
+  // The Memory should have given up the front of its range.
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(1, object().get_generation());
+  ASSERT_EQ(uut_base() + 2 * gate_body_size, memory().get_base());
+  ASSERT_EQ(gate_body_size, memory().get_size());
+  ASSERT_RETURNED_KEY_SHAPE(object(), brand_from_rasr(rw_rasr), 2);
+}
+
+TEST_F(MemoryTest_BecomeArray, slot_key_too_narrow) {
+  auto & m = send_become_array(1, 2, slot(), 0);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_brand);
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind());
+  ASSERT_EQ(Object::Kind::slot, slot2().get_kind())
+    << "a key to one Slot must not claim the next";
+  ASSERT_EQ(0, memory().get_generation());
+}
+
+TEST_F(MemoryTest_BecomeArray, exact_fit) {
+  etl::destroy(memory());
+  new(&_entries[2]) Memory{0, uut_base(), 2 * gate_body_size, 0};
+
+  auto & m = send_become_array(1, 2, slot());
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(2, m.d0);
+  ASSERT_EQ(Object::Kind::gate, slot2().get_kind());
+
+  // No empty Memory is left behind; its entry is free for reuse.
+  ASSERT_EQ(Object::Kind::slot, object().get_kind());
+  ASSERT_EQ(1, object().get_generation());
+  ASSERT_TRUE(static_cast<Slot &>(object()).is_free());
+  ASSERT_RETURNED_KEY_NULL(2);
+}
+
+TEST_F(MemoryTest_BecomeArray, past_end_of_table) {
+  auto & m = send_become_array(1, 2, slot2());
+  ASSERT_RETURNED_EXCEPTION(m, Exception::index_out_of_range);
+  ASSERT_EQ(Object::Kind::slot, slot2().get_kind());
+}
+
+TEST_F(MemoryTest_BecomeArray, not_slot) {
+  auto & m = send_become_array(1, 1, object());
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_kind);
+}
+
+TEST_F(MemoryTest_BecomeArray, interrupt_refused) {
+  auto & m = send_become_array(2, 1, slot());
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+  ASSERT_EQ(Object::Kind::slot, slot().get_kind());
+}
+
+TEST_F(MemoryTest_BecomeArray, too_small) {
+  auto & m = send_become_array(0, 1, slot());
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_operation);
+}
+
 }  // namespace k
 
 int main(int argc, char * argv[]) {
@@ -1,16 +1,93 @@
 #include "k/mm_fault.h"
 
 #include "etl/armv7m/exception_frame.h"
+#include "etl/armv7m/scb.h"
 
+#include "k/context.h"
 #include "k/panic.h"
+#include "k/scheduler.h"
 #include "k/unprivileged.h"  // for mm_fault_recovery_handler
 
+using etl::armv7m::scb;
+
 namespace k {
 
+// Bits in the CFSR indicating that the corresponding fault address register
+// holds a meaningful value.
+static constexpr uint32_t
+  cfsr_mmarvalid = 1u << 7,
+  cfsr_bfarvalid = 1u << 15;
+
+// Bits in the CFSR indicating an MPU access violation on an instruction fetch
+// or a data access, as opposed to during exception entry or return.
+static constexpr uint32_t
+  cfsr_iaccviol = 1u << 0,
+  cfsr_daccviol = 1u << 1;
+
+/*
+ * Collects the fault status from the SCB, clears it for next time, and
+ * reports the fault on behalf of the current Context.
+ */
+static void * report_fault_in_current(void * stack) {
+  auto status = uint32_t(scb.read_cfsr());
+
+  uint32_t address = 0;
+  if (status & cfsr_mmarvalid) {
+    address = uint32_t(scb.read_mmfar());
+  } else if (status & cfsr_bfarvalid) {
+    address = uint32_t(scb.read_bfar());
+  }
+
+  // The status registers are write-one-to-clear.
+  scb.write_cfsr(scb.read_cfsr());
+  scb.write_hfsr(scb.read_hfsr());
+
+  current->set_stack(reinterpret_cast<uint32_t>(stack));
+  current->report_fault(status, address);
+
+  do_deferred_switch();
+  return reinterpret_cast<void *>(current->stack());
+}
+
+/*
+ * Tries to resolve a memory management fault as a miss in the current
+ * Context's region cache.  Returns true if the faulting instruction can be
+ * retried.
+ */
+static bool refill_region_cache(void * stack) {
+  auto status = uint32_t(scb.read_cfsr());
+  if (!(status & (cfsr_iaccviol | cfsr_daccviol))) return false;
+
+  current->set_stack(reinterpret_cast<uint32_t>(stack));
+
+  auto frame = static_cast<etl::armv7m::ExceptionFrame *>(stack);
+  auto maybe_pc = uload(&frame->r15);
+  if (!maybe_pc) return false;
+  auto pc = maybe_pc.ref();
+
+  uint32_t address;
+  if (status & cfsr_mmarvalid) {
+    address = uint32_t(scb.read_mmfar());
+  } else if (status & cfsr_iaccviol) {
+    address = pc;
+  } else {
+    return false;
+  }
+
+  if (!current->refill_region_cache(address, pc)) return false;
+
+  // The status registers are write-one-to-clear.
+  scb.write_cfsr(scb.read_cfsr());
+  return true;
+}
+
 void * mm_fault(void * stack) {
-  // TODO: generate fault message to supervisor.
-  // For now, halt execution here.
-  PANIC("mm fault");
+  if (refill_region_cache(stack)) return stack;
+  return report_fault_in_current(stack);
+}
+
+void * task_fault(void * stack) {
+  return report_fault_in_current(stack);
 }
 
 void mm_fault_k(void * vstack) {
@@ -2,15 +2,22 @@
 #define K_MM_FAULT_H
 
 /*
- * C++ service routines for memory management fault handling.  These are
- * called from the handler in entry.S.
+ * C++ service routines for fault handling.  These are called from the
+ * handlers in entry.S.
+ *
+ * The application versions are entered with the current Context's registers
+ * saved, and return the stack pointer of the Context to resume, which may
+ * differ if the fault caused a context switch.
  */
 
 namespace k {
 
-// Fault in application.
+// Memory management fault in application.
 void * mm_fault(void * stack);
 
+// Bus, usage, or hard fault in application.
+void * task_fault(void * stack);
+
 // Fault in kernel.
 void mm_fault_k(void * vstack);
 
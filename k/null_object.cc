@@ -4,6 +4,6 @@
 
 namespace k {
 
-NullObject::NullObject(Generation g) : Object{g} {}
+NullObject::NullObject(Generation g) : Object{g, Kind::null} {}
 
 }  // namespace k
@@ -15,7 +15,6 @@ namespace k {
 class NullObject final : public Object {
 public:
   NullObject(Generation);
-  Kind get_kind() const override { return Kind::null; }
 };
 
 static_assert(sizeof(NullObject) <= 16,
@@ -30,7 +30,8 @@ protected:
   ObjectTable::Entry _entries[2];
 
   Context::Body _fake_context_body;
-  Context _fake_context{0, _fake_context_body};
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
 
   Spy _spy{0, Object::Kind::context};
   ReplySender _sender;
@@ -3,14 +3,23 @@
 #include "k/context.h"
 #include "k/key.h"
 #include "k/keys.h"
+#include "k/object_table.h"
 #include "k/reply_sender.h"
 #include "k/sender.h"
 
 namespace k {
 
-Object::Object(Generation g) : _generation{g} {}
+Object::Object(Generation g, Kind k) : _generation{g}, _kind{k} {
+  update_table_view(*this);
+}
+
+void Object::set_generation(Generation g) {
+  _generation = g;
+  update_table_view_generation(*this);
+}
 
 Maybe<Key> Object::make_key(Brand const & brand) {
+  if (!Key::can_hold(brand)) return nothing;
   return { Key::filled(this, brand) };
 }
 
@@ -34,8 +43,11 @@ void Object::do_badop(Message const & m, Keys & k) {
 }
 
 void Object::invalidate() {
-  invalidation_hook();
+  // Advance the generation first, so that the hook sees keys to this object as
+  // revoked -- e.g. when reloading MPU regions that referred to it.
   ++_generation;
+  update_table_view_generation(*this);
+  invalidation_hook();
 }
 
 void Object::invalidation_hook() {}
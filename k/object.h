@@ -13,6 +13,7 @@
 #include "common/abi_types.h"
 #include "common/message.h"
 
+#include "k/config.h"
 #include "k/key.h"
 #include "k/list.h"
 #include "k/maybe.h"
@@ -36,18 +37,30 @@ public:
     context,
     gate,
     interrupt,
+    timer,
+    keyring,
   };
 
   /*
    * Sets the generation number for this object.
    */
-  void set_generation(Generation g) { _generation = g; }
+  void set_generation(Generation g);
 
   /*
    * Gets the generation number for this object.
    */
   Generation get_generation() const { return _generation; }
 
+  /*
+   * Checks whether this object's generation is close enough to wrapping
+   * around (as seen by Keys) that advancing it further risks resurrecting old
+   * keys.  See config::generation_guard.
+   */
+  bool is_generation_near_wrap() const {
+    return (_generation & Key::generation_mask)
+        > Key::generation_mask - config::generation_guard;
+  }
+
   /*
    * Invalidates keys to this object by advancing the generation number, and
    * performing any type-specific actions.
@@ -69,18 +82,20 @@ public:
 
   /*
    * Determines the kind (subclass) of this object.  This is used inside the
-   * kernel when a reference to a particular type is required.
+   * kernel when a reference to a particular type is required, and to dispatch
+   * without virtual calls (see k/dispatch.h).
    *
-   * Subclasses should implement this honestly.  Returning a given Kind also
-   * implies permission to static_cast this Object to the corresponding
-   * subclass.
+   * Subclasses must declare their Kind honestly at construction.  Reporting a
+   * given Kind also implies permission to static_cast this Object to the
+   * corresponding subclass.
    */
-  virtual Kind get_kind() const = 0;
+  Kind get_kind() const { return _kind; }
 
   /*
    * Generates a key to this object with the given brand, if the brand is
    * acceptable for this object.  The default implementation accepts all
-   * brands.  Subclasses can implement this to be more selective.
+   * brands that a Key can hold.  Subclasses can implement this to be more
+   * selective.
    */
   virtual Maybe<Key> make_key(Brand const &);
 
@@ -144,7 +159,13 @@ public:
   virtual Region get_region_for_brand(Brand const &) const;
 
 protected:
-  Object(Generation);
+  Object(Generation, Kind);
+
+  /*
+   * Changes the Kind reported by this object.  Real objects never do this;
+   * it exists for test doubles that impersonate other kinds.
+   */
+  void set_kind(Kind k) { _kind = k; }
 
   /*
    * Common implementation for refusing a bad selector.
@@ -153,6 +174,7 @@ protected:
 
 private:
   Generation _generation;
+  Kind _kind;
 
   // Subclass-specific invalidation behavior; by default, does nothing.
   virtual void invalidation_hook();
@@ -1,12 +1,16 @@
 #include "k/object_table.h"
 
+#include "etl/array_count.h"
+
 #include "common/exceptions.h"
 #include "common/message.h"
 #include "common/selectors.h"
 
 #include "k/context.h"
+#include "k/memory.h"
 #include "k/panic.h"
 #include "k/reply_sender.h"
+#include "k/slot.h"
 
 namespace k {
 
@@ -27,7 +31,16 @@ void reset_object_table_for_test() {
   instance = nullptr;
 }
 
-ObjectTable::ObjectTable(Generation g) : Object{g} {}
+void update_table_view(Object const & obj, uintptr_t base, size_t size) {
+  if (instance) instance->publish(obj, base, size);
+}
+
+void update_table_view_generation(Object const & obj) {
+  if (instance) instance->publish_generation(obj);
+}
+
+ObjectTable::ObjectTable(Generation g)
+  : Object{g, Kind::object_table}, _free_head{0}, _view{nullptr} {}
 
 void ObjectTable::set_entries(RangePtr<Entry> entries) {
   PANIC_IF(entries.is_empty(), "ObjectTable entries set to empty range");
@@ -35,6 +48,74 @@ void ObjectTable::set_entries(RangePtr<Entry> entries) {
   _objects = entries;
 }
 
+TableIndex ObjectTable::index_of(Object & object) {
+  auto entry = reinterpret_cast<Entry *>(&object);
+  PANIC_UNLESS(entry >= _objects.base()
+               && entry < _objects.base() + _objects.count(),
+               "object not in table");
+  return TableIndex(entry - _objects.base());
+}
+
+Slot & ObjectTable::slot_at(TableIndex index) {
+  auto & obj = _objects[index].as_object();
+  PANIC_UNLESS(obj.get_kind() == Kind::slot, "non-slot on free list");
+  return static_cast<Slot &>(obj);
+}
+
+void ObjectTable::add_free_slot(Slot & slot) {
+  PANIC_IF(slot._free, "slot freed twice");
+
+  auto index = index_of(slot);
+  slot._free = true;
+  slot._prev_free = 0;
+  slot._next_free = _free_head;
+  if (_free_head) slot_at(_free_head)._prev_free = index;
+  _free_head = index;
+}
+
+void ObjectTable::remove_free_slot(Slot & slot) {
+  PANIC_UNLESS(slot._free, "removing non-free slot");
+
+  if (slot._prev_free) {
+    slot_at(slot._prev_free)._next_free = slot._next_free;
+  } else {
+    _free_head = slot._next_free;
+  }
+  if (slot._next_free) {
+    slot_at(slot._next_free)._prev_free = slot._prev_free;
+  }
+
+  slot._free = false;
+  slot._next_free = slot._prev_free = 0;
+}
+
+TableViewEntry * ObjectTable::view_entry(Object const & object) {
+  if (!_view) return nullptr;
+
+  auto entry = reinterpret_cast<Entry const *>(&object);
+  if (entry < _objects.base() || entry >= _objects.base() + _objects.count()) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<TableViewEntry *>(_view->get_base())
+      + (entry - _objects.base());
+}
+
+void ObjectTable::publish(Object const & object,
+                          uintptr_t base,
+                          size_t size) {
+  if (auto e = view_entry(object)) {
+    e->kind = uint32_t(object.get_kind());
+    e->generation = object.get_generation();
+    e->base = uint32_t(base);
+    e->size = uint32_t(size);
+  }
+}
+
+void ObjectTable::publish_generation(Object const & object) {
+  if (auto e = view_entry(object)) e->generation = object.get_generation();
+}
+
 void ObjectTable::deliver_from(Brand const & brand, Sender * sender) {
   Keys k;
   Message m = sender->on_delivery(k);
@@ -56,6 +137,26 @@ void ObjectTable::deliver_from(Brand const & brand, Sender * sender) {
     case S::invalidate:
       do_invalidate(brand, m, k);
       break;
+
+    case S::mint_keys:
+      do_mint_keys(brand, m, k);
+      break;
+
+    case S::read_kinds:
+      do_read_kinds(brand, m, k);
+      break;
+
+    case S::alloc_slot:
+      do_alloc_slot(brand, m, k);
+      break;
+
+    case S::free_slot:
+      do_free_slot(brand, m, k);
+      break;
+
+    case S::set_table_view:
+      do_set_table_view(brand, m, k);
+      break;
     
     default:
       do_badop(m, k);
@@ -87,7 +188,7 @@ void ObjectTable::do_read_key(Brand const &,
                               Message const &,
                               Keys & keys) {
   auto & k = keys.keys[1];
-  auto index = uint32_t(reinterpret_cast<Entry *>(k.get()) - _objects.base());
+  auto index = index_of(*k.get());
   auto brand = k.get_brand();
 
   ScopedReplySender reply_sender{keys.keys[0], {
@@ -127,12 +228,207 @@ void ObjectTable::do_invalidate(Brand const &,
   }
 
   auto & obj = _objects[index].as_object();
-  if (!rollover_ok && obj.get_generation() == Generation(0) - 1) {
-    reply_sender.message() = Message::failure(Exception::causality);
+
+  // The Null Object must stay at generation zero, or the canonical null key
+  // would stop designating it.
+  if (obj.get_kind() == Kind::null) {
+    reply_sender.message() = Message::failure(Exception::bad_kind);
+    return;
+  }
+
+  // Locked Memory may be in use by hardware, and must not be revoked.
+  if (obj.get_kind() == Kind::memory
+      && static_cast<Memory &>(obj).is_locked()) {
+    reply_sender.message() = Message::failure(Exception::locked);
     return;
   }
 
+  if (obj.is_generation_near_wrap()) {
+    if (!rollover_ok) {
+      reply_sender.message() = Message::failure(Exception::causality);
+      return;
+    }
+
+    // Skip ahead so that this invalidation completes the wrap, rather than
+    // creeping through the remaining generations.
+    obj.set_generation(obj.get_generation() | Key::generation_mask);
+  }
+
   obj.invalidate();
 }
 
+void ObjectTable::do_mint_keys(Brand const &,
+                               Message const & args,
+                               Keys & keys) {
+  uint32_t const indices[] { args.d0, args.d1, args.d2, args.d3 };
+  // Only one data word is left for the brand, so its high half is zero.
+  auto brand = Brand(args.d4);
+
+  ScopedReplySender reply_sender{keys.keys[0]};
+
+  // Validate everything before minting anything, so that failure returns no
+  // keys.
+  for (auto index : indices) {
+    if (index >= _objects.count()) {
+      reply_sender.message() =
+        Message::failure(Exception::index_out_of_range);
+      return;
+    }
+  }
+
+  for (unsigned i = 0; i < etl::array_count(indices); ++i) {
+    // Index zero designates the null object, which produces a null key.
+    if (auto maybe_key = _objects[indices[i]].as_object().make_key(brand)) {
+      reply_sender.set_key(i, maybe_key.ref());
+    } else {
+      reply_sender.message() = Message::failure(Exception::bad_brand);
+      for (unsigned j = 0; j < i; ++j) reply_sender.set_key(j, Key::null());
+      return;
+    }
+  }
+}
+
+void ObjectTable::do_read_kinds(Brand const &,
+                                Message const & args,
+                                Keys & keys) {
+  auto first = args.d0;
+
+  ScopedReplySender reply_sender{keys.keys[0]};
+
+  auto & reply = reply_sender.message();
+  if (first >= _objects.count()) {
+    reply = Message::failure(Exception::index_out_of_range);
+    return;
+  }
+
+  // Entries past the end of the table read as kind zero (null), generation
+  // zero.
+  uint32_t kinds = 0;
+  for (unsigned i = 0; i < 8 && first + i < _objects.count(); ++i) {
+    auto kind = uint32_t(_objects[first + i].as_object().get_kind());
+    kinds |= (kind & 0xF) << (4 * i);
+  }
+  reply.d0 = kinds;
+
+  uint32_t * const generations[] { &reply.d1, &reply.d2, &reply.d3, &reply.d4 };
+  for (unsigned i = 0; i < etl::array_count(generations); ++i) {
+    *generations[i] = first + i < _objects.count()
+        ? _objects[first + i].as_object().get_generation()
+        : 0;
+  }
+}
+
+void ObjectTable::do_alloc_slot(Brand const &,
+                                Message const &,
+                                Keys & keys) {
+  ScopedReplySender reply_sender{keys.keys[0]};
+
+  if (!_free_head) {
+    reply_sender.message() = Message::failure(Exception::exhausted);
+    return;
+  }
+
+  auto index = _free_head;
+  auto & slot = slot_at(index);
+  remove_free_slot(slot);
+
+  reply_sender.message().d0 = index;
+  reply_sender.set_key(1, slot.make_key(0).ref());
+}
+
+void ObjectTable::do_free_slot(Brand const &,
+                               Message const & args,
+                               Keys & keys) {
+  auto index = args.d0;
+
+  ScopedReplySender reply_sender{keys.keys[0]};
+
+  if (index >= _objects.count()) {
+    reply_sender.message() = Message::failure(Exception::index_out_of_range);
+    return;
+  }
+
+  auto & obj = _objects[index].as_object();
+  if (obj.get_kind() != Kind::slot) {
+    reply_sender.message() = Message::failure(Exception::bad_kind);
+    return;
+  }
+
+  auto & slot = static_cast<Slot &>(obj);
+  if (slot.is_free()) return;
+
+  // A Slot that is already near wrap has been retired.  Invalidating it again
+  // would creep toward rollover without the system's consent, so refuse, as
+  // invalidate does.
+  if (slot.is_generation_near_wrap()) {
+    reply_sender.message() = Message::failure(Exception::causality);
+    return;
+  }
+
+  // Revoke keys held by the Slot's previous owner.
+  slot.invalidate();
+
+  // Retire worn-out Slots rather than handing them out again.  The system can
+  // return one to service by invalidating it with rollover permitted, once it
+  // has ensured no stale keys survive, and freeing it again.
+  if (slot.is_generation_near_wrap()) {
+    reply_sender.message().d0 = 1;
+    return;
+  }
+
+  add_free_slot(slot);
+}
+
+void ObjectTable::do_set_table_view(Brand const &,
+                                    Message const &,
+                                    Keys & keys) {
+  ScopedReplySender reply_sender{keys.keys[0]};
+
+  auto & obj = *keys.keys[1].get();
+  Memory * view = nullptr;
+
+  if (obj.get_kind() == Kind::memory) {
+    view = &static_cast<Memory &>(obj);
+
+    if (view->is_device()
+        || view->get_base() % alignof(TableViewEntry)
+        || view->get_size() / sizeof(TableViewEntry) < _objects.count()) {
+      reply_sender.message() = Message::failure(Exception::bad_argument);
+      return;
+    }
+
+    // Pin the view in place for as long as we're writing to it.
+    if (!view->lock()) {
+      reply_sender.message() = Message::failure(Exception::bad_operation);
+      return;
+    }
+  } else if (obj.get_kind() != Kind::null) {
+    // A null key removes the view.
+    reply_sender.message() = Message::failure(Exception::bad_kind);
+    return;
+  }
+
+  // Commit point
+
+  if (_view) _view->unlock();
+  _view = view;
+
+  if (!_view) return;
+
+  // Fill in the whole view.  This is the only part of view maintenance that
+  // depends on the table size; after this, entries are updated as objects
+  // change.
+  for (unsigned i = 0; i < _objects.count(); ++i) {
+    auto & o = _objects[i].as_object();
+    if (o.get_kind() == Kind::memory) {
+      auto & m = static_cast<Memory &>(o);
+      publish(o, m.get_base(), m.get_size());
+    } else {
+      publish(o, 0, 0);
+    }
+  }
+
+  reply_sender.message().d0 = _objects.count();
+}
+
 }  // namespace k
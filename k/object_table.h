@@ -59,7 +59,9 @@
  *
  *  1. O(1) key revocation, by incrementing the Generation field.
  *
- *  2. Protection against key resurrection for 2^32 generations.
+ *  2. Protection against key resurrection for 2^32 generations, with
+ *     objects approaching that limit refused or retired rather than wrapped
+ *     (see config::generation_guard).
  *
  *  3. Relatively small (128-bit) key representation.
  *
@@ -72,15 +74,20 @@
  * though the implementation details are quite different.
  */
 
+#include <cstddef>
 #include <cstdint>
 
 #include "common/abi_types.h"
+#include "common/table_view.h"
 
 #include "k/object.h"
 #include "k/range_ptr.h"
 
 namespace k {
 
+class Memory;  // see: k/memory.h
+struct Slot;  // see: k/slot.h
+
 class ObjectTable final : public Object {
 public:
   ObjectTable(Generation);
@@ -108,17 +115,73 @@ public:
     return _objects[index].as_object();
   }
 
+  /*
+   * Gets the number of entries in the table.
+   */
+  TableIndex size() const { return TableIndex(_objects.count()); }
+
+  /*
+   * Finds the index of an Object by address.
+   *
+   * Precondition: the Object lives in this table.
+   */
+  TableIndex index_of(Object &);
+
+  /*
+   * Adds a Slot to the free list, from which the system can claim it using
+   * alloc_slot.
+   *
+   * Precondition: the Slot lives in this table, and is not free.
+   */
+  void add_free_slot(Slot &);
+
+  /*
+   * Removes a Slot from the free list.
+   *
+   * Precondition: the Slot is free.
+   */
+  void remove_free_slot(Slot &);
+
+  /*
+   * Checks whether the given Memory holds the table view.
+   */
+  bool is_view(Memory const & m) const { return _view == &m; }
+
+  /*
+   * Updates an Object's entry in the table view, if there is one, with its
+   * kind and generation, and the given extent.  Objects outside the table are
+   * ignored.
+   */
+  void publish(Object const &, uintptr_t base, size_t size);
+
+  /*
+   * Updates only the generation in an Object's entry in the table view.
+   */
+  void publish_generation(Object const &);
+
   // Implementation of Object.
-  Kind get_kind() const override { return Kind::object_table; }
   void deliver_from(Brand const &, Sender *) override;
 
 private:
   RangePtr<Entry> _objects;
+  // Table index of the first free Slot, or zero if there are none.
+  TableIndex _free_head;
+  // Memory holding the table view, or null if there is none.  The table
+  // holds a lock on it, so it can't move underneath us.
+  Memory * _view;
+
+  Slot & slot_at(TableIndex);
+  TableViewEntry * view_entry(Object const &);
 
   void do_mint_key(Brand const &, Message const &, Keys &);
   void do_read_key(Brand const &, Message const &, Keys &);
   void do_get_kind(Brand const &, Message const &, Keys &);
   void do_invalidate(Brand const &, Message const &, Keys &);
+  void do_mint_keys(Brand const &, Message const &, Keys &);
+  void do_read_kinds(Brand const &, Message const &, Keys &);
+  void do_alloc_slot(Brand const &, Message const &, Keys &);
+  void do_free_slot(Brand const &, Message const &, Keys &);
+  void do_set_table_view(Brand const &, Message const &, Keys &);
 };
 
 /*
@@ -128,6 +191,13 @@ ObjectTable & object_table();
 void set_object_table(ObjectTable *);
 void reset_object_table_for_test();
 
+/*
+ * Keep the table view, if any, in step with changes to an Object.  These are
+ * safe to call before the Object Table exists, and for Objects outside it.
+ */
+void update_table_view(Object const &, uintptr_t base = 0, size_t size = 0);
+void update_table_view_generation(Object const &);
+
 }  // namespace k
 
 #endif  // K_OBJECT_TABLE_H
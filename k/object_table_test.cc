@@ -0,0 +1,529 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+
+#include "etl/destroy.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/config.h"
+#include "k/context.h"
+#include "k/memory.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+#include "k/slot.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+namespace S = selector::object_table;
+
+class ObjectTableTest : public ::testing::Test {
+protected:
+  static constexpr unsigned first_slot = 2, slot_count = 4;
+
+  ObjectTable::Entry _entries[first_slot + slot_count];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    for (unsigned i = 0; i < slot_count; ++i) {
+      new(&_entries[first_slot + i]) Slot{0};
+    }
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  ObjectTable & table() {
+    return *static_cast<ObjectTable *>(&_entries[1].as_object());
+  }
+
+  Slot & slot(unsigned i) {
+    return *static_cast<Slot *>(&_entries[first_slot + i].as_object());
+  }
+
+  Message const & send_from_spy(Message m) {
+    auto count = _spy.count();
+
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    table().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+
+  Message const & alloc_slot() {
+    return send_from_spy({Descriptor::call(S::alloc_slot, 0)});
+  }
+
+  Message const & free_slot(TableIndex index) {
+    return send_from_spy({Descriptor::call(S::free_slot, 0), index});
+  }
+
+  Message const & invalidate(TableIndex index, bool rollover_ok) {
+    return send_from_spy({
+        Descriptor::call(S::invalidate, 0),
+        index,
+        rollover_ok,
+        });
+  }
+
+  Message const & mint_keys(TableIndex i0, TableIndex i1,
+                            TableIndex i2, TableIndex i3,
+                            uint32_t brand) {
+    return send_from_spy({
+        Descriptor::call(S::mint_keys, 0),
+        i0, i1, i2, i3,
+        brand,
+        });
+  }
+
+  Message const & read_kinds(TableIndex first) {
+    return send_from_spy({Descriptor::call(S::read_kinds, 0), first});
+  }
+
+  Message const & set_table_view(Key const & k) {
+    _sender.set_key(1, k);
+    auto & m = send_from_spy({Descriptor::call(S::set_table_view, 0)});
+    _sender.set_key(1, Key::null());
+    return m;
+  }
+
+  // First generation considered near wrap.
+  static constexpr Generation first_worn_generation =
+    Key::generation_mask - config::generation_guard + 1;
+};
+
+constexpr unsigned ObjectTableTest::first_slot, ObjectTableTest::slot_count;
+constexpr Generation ObjectTableTest::first_worn_generation;
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+TEST_F(ObjectTableTest, alloc_when_empty) {
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+}
+
+TEST_F(ObjectTableTest, free_then_alloc) {
+  auto index = first_slot + 1;
+
+  ASSERT_MESSAGE_SUCCESS(free_slot(index));
+  ASSERT_TRUE(slot(1).is_free());
+  ASSERT_EQ(1, slot(1).get_generation())
+    << "freeing a slot should revoke keys to it";
+
+  auto & m = alloc_slot();
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(index, m.d0);
+  ASSERT_FALSE(slot(1).is_free());
+
+  auto & k = _spy.keys().keys[1];
+  ASSERT_EQ(&slot(1), k.get());
+  ASSERT_EQ(1, k.get_generation());
+
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+}
+
+TEST_F(ObjectTableTest, free_twice) {
+  ASSERT_MESSAGE_SUCCESS(free_slot(first_slot));
+  ASSERT_MESSAGE_SUCCESS(free_slot(first_slot));
+  ASSERT_EQ(1, slot(0).get_generation())
+    << "freeing a free slot should have no effect";
+
+  ASSERT_MESSAGE_SUCCESS(alloc_slot());
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+}
+
+TEST_F(ObjectTableTest, free_non_slot) {
+  ASSERT_RETURNED_EXCEPTION(free_slot(1), Exception::bad_kind);
+}
+
+TEST_F(ObjectTableTest, free_out_of_range) {
+  ASSERT_RETURNED_EXCEPTION(free_slot(first_slot + slot_count),
+                            Exception::index_out_of_range);
+}
+
+TEST_F(ObjectTableTest, alloc_all) {
+  for (unsigned i = 0; i < slot_count; ++i) {
+    ASSERT_MESSAGE_SUCCESS(free_slot(first_slot + i));
+  }
+
+  bool seen[slot_count] {};
+  for (unsigned i = 0; i < slot_count; ++i) {
+    auto & m = alloc_slot();
+    ASSERT_MESSAGE_SUCCESS(m);
+    ASSERT_LE(first_slot, m.d0);
+    ASSERT_GT(first_slot + slot_count, m.d0);
+    ASSERT_FALSE(seen[m.d0 - first_slot]) << "slot allocated twice";
+    seen[m.d0 - first_slot] = true;
+  }
+
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+}
+
+TEST_F(ObjectTableTest, destroying_free_slot_unlinks) {
+  for (unsigned i = 0; i < slot_count; ++i) {
+    ASSERT_MESSAGE_SUCCESS(free_slot(first_slot + i));
+  }
+
+  // Simulate donation of a free slot from the middle of the list, e.g. by
+  // Memory split.
+  auto & victim = slot(2);
+  etl::destroy(victim);
+  new(&victim) Memory{0, 0, 0, 0};
+
+  for (unsigned i = 0; i < slot_count - 1; ++i) {
+    auto & m = alloc_slot();
+    ASSERT_MESSAGE_SUCCESS(m);
+    ASSERT_NE(first_slot + 2, m.d0) << "destroyed slot must not be allocated";
+  }
+
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+}
+
+TEST_F(ObjectTableTest, invalidate_locked_memory) {
+  auto & victim = slot(0);
+  etl::destroy(victim);
+  auto & mem = *new(&victim) Memory{0, 0, 0, 0};
+
+  Spy lock_spy{0, Object::Kind::context};
+  ReplySender sender{{Descriptor::call(selector::memory::lock, 0)}};
+  sender.set_key(0, lock_spy.make_key(0).ref());
+  mem.deliver_from(0, &sender);
+  ASSERT_TRUE(mem.is_locked());
+
+  ASSERT_RETURNED_EXCEPTION(invalidate(first_slot, false), Exception::locked);
+  ASSERT_EQ(0, mem.get_generation());
+}
+
+TEST_F(ObjectTableTest, invalidate_null) {
+  ASSERT_RETURNED_EXCEPTION(invalidate(0, false), Exception::bad_kind);
+  ASSERT_EQ(0, _entries[0].as_object().get_generation());
+}
+
+/*
+ * Mint Keys and Read Kinds
+ */
+
+// Stands in for an object that vetoes every brand, which no object in a
+// default kernel build does for brands that fit in 32 bits.
+class VetoObject : public Object {
+public:
+  VetoObject() : Object{0, Kind::gate} {}
+
+  Maybe<Key> make_key(Brand const &) override { return nothing; }
+};
+
+#define ASSERT_NO_RETURNED_KEYS() \
+  for (unsigned __i = 0; __i < config::n_message_keys; ++__i) { \
+    ASSERT_EQ(Object::Kind::null, _spy.keys().keys[__i].get()->get_kind()) \
+      << "no keys should be returned, but got key " << __i; \
+  }
+
+TEST_F(ObjectTableTest, mint_keys) {
+  auto & m = mint_keys(first_slot, 0, first_slot + 2, 0, 7);
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  auto & keys = _spy.keys().keys;
+  ASSERT_EQ(&slot(0), keys[0].get());
+  ASSERT_EQ(7u, keys[0].get_brand());
+  ASSERT_EQ(Object::Kind::null, keys[1].get()->get_kind())
+    << "index zero should produce a null key";
+  ASSERT_EQ(&slot(2), keys[2].get());
+  ASSERT_EQ(7u, keys[2].get_brand());
+  ASSERT_EQ(Object::Kind::null, keys[3].get()->get_kind());
+}
+
+TEST_F(ObjectTableTest, mint_keys_checks_all_indices_first) {
+  // A valid index before the bad one must not be minted.
+  auto & m = mint_keys(first_slot, first_slot + 1,
+                       first_slot + slot_count, 0, 0);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::index_out_of_range);
+  ASSERT_NO_RETURNED_KEYS();
+}
+
+TEST_F(ObjectTableTest, mint_keys_bad_brand_returns_no_keys) {
+  etl::destroy(slot(1));
+  new(&_entries[first_slot + 1]) VetoObject;
+
+  // The first key is minted before the second is vetoed, and must be taken
+  // back.
+  auto & m = mint_keys(first_slot, first_slot + 1, 0, 0, 0);
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_brand);
+  ASSERT_NO_RETURNED_KEYS();
+}
+
+TEST_F(ObjectTableTest, read_kinds) {
+  slot(1).set_generation(3);
+
+  auto & m = read_kinds(0);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(uint32_t(Object::Kind::null), m.d0 & 0xF);
+  ASSERT_EQ(uint32_t(Object::Kind::object_table), (m.d0 >> 4) & 0xF);
+  for (unsigned i = 0; i < slot_count; ++i) {
+    ASSERT_EQ(uint32_t(Object::Kind::slot),
+              (m.d0 >> (4 * (first_slot + i))) & 0xF);
+  }
+  ASSERT_EQ(0u, m.d1);
+  ASSERT_EQ(0u, m.d2);
+  ASSERT_EQ(0u, m.d3);
+  ASSERT_EQ(3u, m.d4);
+}
+
+TEST_F(ObjectTableTest, read_kinds_past_end) {
+  slot(slot_count - 1).set_generation(5);
+
+  // Only the last two entries exist.
+  auto & m = read_kinds(first_slot + slot_count - 2);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(uint32_t(Object::Kind::slot)
+              | (uint32_t(Object::Kind::slot) << 4),
+            m.d0) << "entries past the end should read as null";
+  ASSERT_EQ(0u, m.d1);
+  ASSERT_EQ(5u, m.d2);
+  ASSERT_EQ(0u, m.d3);
+  ASSERT_EQ(0u, m.d4);
+}
+
+TEST_F(ObjectTableTest, read_kinds_out_of_range) {
+  ASSERT_RETURNED_EXCEPTION(read_kinds(first_slot + slot_count),
+                            Exception::index_out_of_range);
+}
+
+/*
+ * Table view
+ */
+
+alignas(TableViewEntry) static TableViewEntry view_buffer[8];
+
+static uint32_t view_base() {
+  return uint32_t(reinterpret_cast<uintptr_t>(view_buffer));
+}
+
+TEST_F(ObjectTableTest, table_view_tracks_objects) {
+  auto & victim = slot(0);
+  etl::destroy(victim);
+  auto & mem = *new(&victim) Memory{0, view_base(), sizeof(view_buffer), 0};
+
+  auto & m = set_table_view(mem.make_key(0).ref());
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(first_slot + slot_count, m.d0);
+
+  ASSERT_EQ(uint32_t(Object::Kind::object_table), view_buffer[1].kind);
+  ASSERT_EQ(uint32_t(Object::Kind::memory), view_buffer[first_slot].kind);
+  ASSERT_EQ(view_base(), view_buffer[first_slot].base);
+  ASSERT_EQ(sizeof(view_buffer), view_buffer[first_slot].size);
+  ASSERT_EQ(uint32_t(Object::Kind::slot), view_buffer[first_slot + 1].kind);
+  ASSERT_EQ(0u, view_buffer[first_slot + 1].size);
+
+  // Invalidation is published.
+  ASSERT_MESSAGE_SUCCESS(free_slot(first_slot + 1));
+  ASSERT_EQ(1u, view_buffer[first_slot + 1].generation);
+
+  // So is replacing an object, e.g. by split.
+  etl::destroy(slot(2));
+  new(&slot(2)) Memory{5, 0x1000, 0x100, 0};
+  auto & e = view_buffer[first_slot + 2];
+  ASSERT_EQ(uint32_t(Object::Kind::memory), e.kind);
+  ASSERT_EQ(5u, e.generation);
+  ASSERT_EQ(0x1000u, e.base);
+  ASSERT_EQ(0x100u, e.size);
+}
+
+TEST_F(ObjectTableTest, table_view_is_locked) {
+  auto & victim = slot(0);
+  etl::destroy(victim);
+  auto & mem = *new(&victim) Memory{0, view_base(), sizeof(view_buffer), 0};
+
+  ASSERT_MESSAGE_SUCCESS(set_table_view(mem.make_key(0).ref()));
+  ASSERT_TRUE(mem.is_locked());
+  ASSERT_RETURNED_EXCEPTION(invalidate(first_slot, false), Exception::locked);
+
+  // The kernel's lock can't be released through the Memory.
+  Spy unlock_spy{0, Object::Kind::context};
+  ReplySender sender{{Descriptor::call(selector::memory::unlock, 0)}};
+  sender.set_key(0, unlock_spy.make_key(0).ref());
+  mem.deliver_from(0, &sender);
+  ASSERT_TRUE(unlock_spy.message().m.desc.get_error());
+  ASSERT_TRUE(mem.is_locked());
+
+  // Removing the view releases the lock.
+  ASSERT_MESSAGE_SUCCESS(set_table_view(Key::null()));
+  ASSERT_FALSE(mem.is_locked());
+}
+
+TEST_F(ObjectTableTest, table_view_too_small) {
+  auto & victim = slot(0);
+  etl::destroy(victim);
+  auto & mem = *new(&victim) Memory{
+    0, view_base(), sizeof(TableViewEntry) * (first_slot + slot_count - 1), 0};
+
+  ASSERT_RETURNED_EXCEPTION(set_table_view(mem.make_key(0).ref()),
+                            Exception::bad_argument);
+  ASSERT_FALSE(mem.is_locked());
+}
+
+TEST_F(ObjectTableTest, table_view_not_memory) {
+  ASSERT_RETURNED_EXCEPTION(set_table_view(slot(0).make_key(0).ref()),
+                            Exception::bad_kind);
+}
+
+/*
+ * Generation wraparound
+ */
+
+TEST_F(ObjectTableTest, near_wrap_boundary) {
+  slot(0).set_generation(first_worn_generation - 1);
+  ASSERT_FALSE(slot(0).is_generation_near_wrap());
+
+  slot(0).set_generation(first_worn_generation);
+  ASSERT_TRUE(slot(0).is_generation_near_wrap());
+
+  slot(0).set_generation(Key::generation_mask);
+  ASSERT_TRUE(slot(0).is_generation_near_wrap());
+
+  slot(0).set_generation(0);
+  ASSERT_FALSE(slot(0).is_generation_near_wrap());
+}
+
+TEST_F(ObjectTableTest, invalidate_near_wrap) {
+  slot(0).set_generation(first_worn_generation);
+
+  ASSERT_RETURNED_EXCEPTION(invalidate(first_slot, false),
+                            Exception::causality);
+  ASSERT_EQ(first_worn_generation, slot(0).get_generation());
+
+  ASSERT_MESSAGE_SUCCESS(invalidate(first_slot, true));
+  ASSERT_EQ(0, slot(0).get_generation() & Key::generation_mask)
+    << "permitted rollover should complete the wrap in one step";
+  ASSERT_FALSE(slot(0).is_generation_near_wrap());
+}
+
+TEST_F(ObjectTableTest, free_slot_retires_worn_slot) {
+  // Freeing invalidates, which will make this one near wrap.
+  slot(0).set_generation(first_worn_generation - 1);
+
+  auto & m = free_slot(first_slot);
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_EQ(1, m.d0) << "worn slot should be reported as retired";
+  ASSERT_FALSE(slot(0).is_free());
+
+  ASSERT_RETURNED_EXCEPTION(alloc_slot(), Exception::exhausted);
+
+  // The system can reclaim it explicitly.
+  ASSERT_MESSAGE_SUCCESS(invalidate(first_slot, true));
+  ASSERT_EQ(0, free_slot(first_slot).d0);
+  ASSERT_TRUE(slot(0).is_free());
+}
+
+TEST_F(ObjectTableTest, free_retired_slot_repeatedly) {
+  slot(0).set_generation(first_worn_generation - 1);
+  ASSERT_EQ(1, free_slot(first_slot).d0);
+  auto g = slot(0).get_generation();
+
+  // Repeated frees must not walk the generation around to zero.
+  for (unsigned i = 0; i < config::generation_guard + 1; ++i) {
+    ASSERT_RETURNED_EXCEPTION(free_slot(first_slot), Exception::causality);
+    ASSERT_EQ(g, slot(0).get_generation());
+    ASSERT_FALSE(slot(0).is_free());
+  }
+}
+
+/*
+ * Churns a single slot through free/alloc cycles across the entire generation
+ * space.  Actually performing 2^32 cycles would take too long, so the test
+ * skips ahead through the generations, running a burst of real cycles in each
+ * step, up to the one that hits the guard band.
+ */
+TEST_F(ObjectTableTest, churn_across_generation_space) {
+  static constexpr unsigned burst = 32;
+  static constexpr Generation stride =
+    Key::generation_mask == ~Generation(0) ? (1u << 16) : (1u << 4);
+
+  unsigned retirements = 0;
+  uint64_t cycles = 0;
+
+  for (uint64_t start = 0;
+       start <= Key::generation_mask;
+       start += stride) {
+    // Skip most of each stride, landing just short of its end -- or of the
+    // guard band, since Slots within it are retired, and can't be freed.
+    auto g = Generation(std::min<uint64_t>(start + stride - burst / 2,
+                                           first_worn_generation - burst / 2));
+    slot(0).set_generation(g);
+
+    for (unsigned i = 0; i < burst; ++i) {
+      auto old_key = slot(0).make_key(0).ref();
+      bool expect_retired =
+        ((slot(0).get_generation() + 1) & Key::generation_mask)
+          >= first_worn_generation;
+
+      auto & m = free_slot(first_slot);
+      ASSERT_MESSAGE_SUCCESS(m);
+      ASSERT_EQ(Object::Kind::null, old_key.get()->get_kind())
+        << "freeing must revoke keys, at generation " << g + i;
+
+      if (m.d0) {
+        ASSERT_TRUE(expect_retired) << "retired too early at " << g + i;
+        ++retirements;
+        // Recover, as a system would after scavenging.
+        ASSERT_MESSAGE_SUCCESS(invalidate(first_slot, true));
+        continue;
+      }
+
+      ASSERT_FALSE(expect_retired) << "failed to retire at " << g + i;
+
+      auto & a = alloc_slot();
+      ASSERT_MESSAGE_SUCCESS(a);
+      ASSERT_EQ(first_slot, a.d0);
+      ++cycles;
+    }
+
+    // Everything past here is in the guard band.
+    if (g >= first_worn_generation - burst / 2) break;
+  }
+
+  ASSERT_LT(0u, retirements) << "the guard band should have been crossed";
+  ASSERT_LT(0u, cycles);
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,6 +1,8 @@
 #ifndef K_REGION_H
 #define K_REGION_H
 
+#include <cstdint>
+
 #include "etl/armv7m/mpu.h"
 
 namespace k {
@@ -11,6 +13,24 @@ struct Region {
 
   Rbar rbar;
   Rasr rasr;
+
+  /*
+   * Checks whether this region, if loaded, would cover 'addr', taking
+   * subregion disables into account.  Access permissions are not considered.
+   */
+  bool contains(uintptr_t addr) const {
+    if (!rasr.get_enable()) return false;
+
+    auto l2_size = unsigned(rasr.get_size()) + 1;
+    auto offset = uint32_t(addr - (rbar.get_addr_27() << 5));
+    // Shift in two steps, since a 4 GiB region has l2_size == 32.
+    if ((offset >> (l2_size - 1)) >> 1) return false;
+
+    // Only regions of 256 bytes or more have subregions.
+    if (l2_size < 8) return true;
+    auto subregion = offset >> (l2_size - 3);
+    return !(rasr.get_srd() & (1u << subregion));
+  }
 };
 
 }  // namespace k
@@ -0,0 +1,67 @@
+#ifndef K_REGION_CACHE_H
+#define K_REGION_CACHE_H
+
+/*
+ * Replacement policy for a Context's region cache: a set of MPU region
+ * registers that the kernel refills, on demand, from a Keyring of region keys
+ * when the program faults on an address they don't cover.  This lets a
+ * program use more regions than the hardware has.
+ *
+ * The policy is the clock algorithm.  The hardware doesn't keep referenced
+ * bits for MPU regions, so the kernel sets them itself: when a region is
+ * loaded, and when the program faults while its code or stack is in a
+ * region, which shows that region to be in use.
+ *
+ * This has no dependencies on the hardware, so that it can be simulated on
+ * the host (see k/region_cache_sim.cc).
+ */
+
+#include <cstdint>
+
+#include "k/config.h"
+#include "k/panic.h"
+
+namespace k {
+
+struct RegionClock {
+  // Index of the region register most recently considered for replacement.
+  uint8_t hand{0};
+  // Bitmask of region registers referenced since the hand last passed.
+  uint8_t referenced{0};
+
+  static_assert(config::n_task_regions <= 8,
+      "referenced bits must fit in a uint8_t");
+
+  void touch(unsigned index) {
+    referenced = uint8_t(referenced | (1u << index));
+  }
+
+  void reset() {
+    hand = 0;
+    referenced = 0;
+  }
+
+  /*
+   * Chooses a region register to replace from the (non-empty) set
+   * 'candidates', advancing the hand.  Referenced candidates are passed over
+   * once, losing their referenced bits, so this terminates within two turns.
+   */
+  unsigned choose(unsigned candidates) {
+    PANIC_UNLESS(candidates, "no region to replace");
+
+    for (;;) {
+      hand = uint8_t((hand + 1) % config::n_task_regions);
+      auto bit = 1u << hand;
+      if (!(candidates & bit)) continue;
+      if (referenced & bit) {
+        referenced = uint8_t(referenced & ~bit);
+        continue;
+      }
+      return hand;
+    }
+  }
+};
+
+}  // namespace k
+
+#endif  // K_REGION_CACHE_H
@@ -0,0 +1,204 @@
+/*
+ * Host simulation of region cache fault rates (see k/region_cache.h).
+ *
+ * A program's accesses are modeled as a trace of (code, data) pairs of window
+ * numbers: each step fetches an instruction from a code window, then accesses
+ * a data window.  Windows not in the cache cost a fault to load.  The stack is
+ * assumed to be in a region register outside the cache, as recommended.
+ *
+ * Three policies are compared:
+ *
+ * - clock: the kernel's, using RegionClock with the same touches the kernel
+ *   makes -- on load, and on the region holding the code at each fault.
+ * - fifo: RegionClock touching only on load, i.e. without the code heuristic.
+ * - lru: true least-recently-used.  The kernel can't implement this, since
+ *   the hardware doesn't report hits, but it makes a useful yardstick.
+ *
+ * Results are in faults per thousand steps.
+ */
+
+#include <cstdio>
+
+#include "k/config.h"
+#include "k/region_cache.h"
+
+namespace k {
+
+static constexpr unsigned steps = 200 * 1000;
+static constexpr unsigned no_window = ~0u;
+
+/*
+ * Deterministic pseudo-random numbers, so that runs can be compared.
+ */
+class Random {
+public:
+  unsigned below(unsigned n) {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state % n;
+  }
+
+private:
+  uint32_t _state{0x12345678};
+};
+
+enum class Policy { clock, fifo, lru };
+
+class Cache {
+public:
+  Cache(Policy policy, unsigned size) : _policy{policy}, _size{size} {
+    for (auto & w : _windows) w = no_window;
+  }
+
+  unsigned faults() const { return _faults; }
+
+  void step(unsigned code, unsigned data) {
+    access(code, code);
+    access(data, code);
+  }
+
+private:
+  Policy _policy;
+  unsigned _size;
+  unsigned _windows[config::n_task_regions];
+  unsigned _last_use[config::n_task_regions]{};
+  unsigned _now{0};
+  unsigned _faults{0};
+  RegionClock _clock{};
+
+  unsigned find(unsigned window) const {
+    for (unsigned i = 0; i < _size; ++i) {
+      if (_windows[i] == window) return i;
+    }
+    return no_window;
+  }
+
+  void access(unsigned window, unsigned code) {
+    ++_now;
+    auto slot = find(window);
+    if (slot == no_window) {
+      ++_faults;
+      slot = replace(code);
+      _windows[slot] = window;
+      _clock.touch(slot);
+    }
+    _last_use[slot] = _now;
+  }
+
+  unsigned replace(unsigned code) {
+    if (_policy == Policy::lru) {
+      unsigned victim = 0;
+      for (unsigned i = 1; i < _size; ++i) {
+        if (_last_use[i] < _last_use[victim]) victim = i;
+      }
+      return victim;
+    }
+
+    if (_policy == Policy::clock) {
+      auto code_slot = find(code);
+      if (code_slot != no_window) _clock.touch(code_slot);
+    }
+    return _clock.choose((1u << _size) - 1);
+  }
+};
+
+/*
+ * Access patterns.  Each produces the next (code, data) pair.
+ */
+
+// Data accesses spread evenly over all windows; code in one of two windows.
+struct Uniform {
+  char const * name = "uniform";
+  unsigned windows;
+  Random r;
+
+  void next(unsigned & code, unsigned & data) {
+    code = r.below(2);
+    data = 2 + r.below(windows - 2);
+  }
+};
+
+// Most accesses go to a few hot windows, as with a driver touching its
+// peripheral often and its buffers less so.
+struct Skewed {
+  char const * name = "skewed";
+  unsigned windows;
+  Random r;
+
+  void next(unsigned & code, unsigned & data) {
+    code = r.below(10) ? 0 : 1;
+    data = r.below(10) < 8 ? 2 + r.below(2) : 2 + r.below(windows - 2);
+  }
+};
+
+// The program works on a small set of windows for a while, then moves on.
+struct Phased {
+  char const * name = "phased";
+  unsigned windows;
+  Random r;
+  unsigned n{0};
+
+  void next(unsigned & code, unsigned & data) {
+    auto phase = n++ / 1000;
+    code = phase % 2;
+    data = 2 + (phase * 3 + r.below(3)) % (windows - 2);
+  }
+};
+
+// Data accesses cycle through every window in turn: the worst case for any
+// recency-based policy once the windows outnumber the cache.
+struct Scan {
+  char const * name = "scan";
+  unsigned windows;
+  unsigned n{0};
+
+  void next(unsigned & code, unsigned & data) {
+    code = 0;
+    data = 2 + (n++ % (windows - 2));
+  }
+};
+
+template <typename Pattern>
+static void simulate(unsigned windows, unsigned size) {
+  static constexpr Policy policies[] {Policy::clock, Policy::fifo, Policy::lru};
+
+  std::printf("%-8s %7u %5u", Pattern{}.name, windows, size);
+  for (auto policy : policies) {
+    Pattern pattern{};
+    pattern.windows = windows;
+    Cache cache{policy, size};
+
+    for (unsigned i = 0; i < steps; ++i) {
+      unsigned code, data;
+      pattern.next(code, data);
+      cache.step(code, data);
+    }
+
+    std::printf(" %8.1f", cache.faults() * 1000.0 / steps);
+  }
+  std::printf("\n");
+}
+
+template <typename Pattern>
+static void simulate_sizes(unsigned windows) {
+  for (unsigned size = 3; size <= config::n_task_regions; ++size) {
+    simulate<Pattern>(windows, size);
+  }
+}
+
+}  // namespace k
+
+int main() {
+  std::printf("%-8s %7s %5s %8s %8s %8s\n",
+      "pattern", "windows", "cache", "clock", "fifo", "lru");
+
+  static constexpr unsigned window_counts[] {10, 20};
+  for (auto windows : window_counts) {
+    k::simulate_sizes<k::Uniform>(windows);
+    k::simulate_sizes<k::Skewed>(windows);
+    k::simulate_sizes<k::Phased>(windows);
+    k::simulate_sizes<k::Scan>(windows);
+  }
+  return 0;
+}
@@ -50,6 +50,18 @@ union SavedRegisters {
   SavedRegisters() : raw{} {}  // Zero on creation
 };
 
+/*
+ * Register state used to restart a Context from its entry point: the
+ * kernel-saved registers other than BASEPRI (which restarts as zero), plus
+ * the program counter, so that the kernel can rebuild the hardware-saved
+ * frame on the stack.
+ */
+struct RestartRegisters {
+  uint32_t r4_r11[8];
+  uint32_t stack;
+  uint32_t pc;
+};
+
 // Some basic consistency checks of the SavedRegisters union.
 
 static_assert(sizeof(static_cast<SavedRegisters *>(nullptr)->raw)
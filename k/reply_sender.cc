@@ -2,6 +2,7 @@
 
 #include "etl/array_count.h"
 
+#include "k/dispatch.h"
 #include "k/object.h"
 #include "k/panic.h"
 
@@ -35,7 +36,7 @@ void ReplySender::block_in_send(Brand const &, List<BlockingSender> &) {
 ScopedReplySender::~ScopedReplySender() {
   auto obj = k.get();
   if (obj->get_kind() == Object::Kind::null) return;
-  obj->deliver_from(k.get_brand(), &rs);
+  dispatch::deliver_from(*obj, k.get_brand(), &rs);
 }
 
 }  // namespace k
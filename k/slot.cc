@@ -1,11 +1,14 @@
 #include "k/slot.h"
 
+#include "k/object_table.h"
 #include "k/sender.h"
 
 namespace k {
 
-/*
- * This file exists to ensure that slot.h didn't forget any #includes.
- */
+template struct ObjectSubclassChecks<Slot, 0>;
+
+Slot::~Slot() {
+  if (_free) object_table().remove_free_slot(*this);
+}
 
 }  // namespace k
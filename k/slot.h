@@ -4,16 +4,35 @@
 /*
  * A Slot object represents the capability to create an object in an Object
  * Table slot.
+ *
+ * Slots may be kept on the Object Table's free list, which is threaded through
+ * the Slots themselves by table index.  A free Slot removes itself from the
+ * list when it's destroyed -- e.g. when it's donated to create a new object.
  */
 
+#include "common/abi_types.h"
+
 #include "k/object.h"
 
 namespace k {
 
 class Slot final : public Object {
 public:
-  Slot(Generation g) : Object{g} {}
-  Kind get_kind() const override { return Kind::slot; }
+  Slot(Generation g) : Object{g, Kind::slot} {}
+  ~Slot();
+
+
+  bool is_free() const { return _free; }
+
+private:
+  friend class ObjectTable;
+
+  // Whether this Slot is on the free list.
+  bool _free{false};
+  // Free list neighbors, by table index.  Zero (the index of the null object)
+  // terminates the list.
+  TableIndex _next_free{0};
+  TableIndex _prev_free{0};
 };
 
 }  // namespace k
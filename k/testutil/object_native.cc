@@ -1,15 +1,25 @@
 #include "k/object.h"
 
+#include "k/context.h"
 #include "k/key.h"
 #include "k/keys.h"
+#include "k/object_table.h"
 #include "k/reply_sender.h"
 #include "k/sender.h"
 
 namespace k {
 
-Object::Object(Generation g) : _generation{g} {}
+Object::Object(Generation g, Kind k) : _generation{g}, _kind{k} {
+  update_table_view(*this);
+}
+
+void Object::set_generation(Generation g) {
+  _generation = g;
+  update_table_view_generation(*this);
+}
 
 Maybe<Key> Object::make_key(Brand const & brand) {
+  if (!Key::can_hold(brand)) return nothing;
   return { Key::filled(this, brand) };
 }
 
@@ -20,6 +30,7 @@ void Object::deliver_from(Brand const &, Sender * sender) {
 }
 
 void Object::deliver_to(Brand const &, Context * ctx) {
+  ctx->complete_receive(Exception::bad_operation);
 }
 
 Region Object::get_region_for_brand(Brand const &) const {
@@ -34,6 +45,7 @@ void Object::do_badop(Message const & m, Keys & k) {
 void Object::invalidate() {
   invalidation_hook();
   ++_generation;
+  update_table_view_generation(*this);
 }
 
 void Object::invalidation_hook() {}
@@ -18,25 +18,22 @@ class Sender;  // see: k/sender.h
 class Spy : public Object {
 public:
   Spy(Generation g, Kind k)
-    : Object{g},
+    : Object{g, k},
       _received{{}, 0},
-      _count{},
-     _kind{k} {}
+      _count{} {}
 
   ReceivedMessage const & message() const { return _received; }
   Keys & keys() { return _keys; }
   unsigned count() const { return _count; }
 
-  void set_kind(Kind k) { _kind = k; }
+  using Object::set_kind;
 
-  Kind get_kind() const override { return _kind; }
   void deliver_from(Brand const &, Sender *) override;
 
 private:
   ReceivedMessage _received;
   Keys _keys;
   unsigned _count;
-  Kind _kind;
 };
 
 }  // namespace k
@@ -5,20 +5,32 @@ using etl::armv7m::Word;
 
 namespace k {
 
+/*
+ * The fakes treat the bottom page of the address space as unmapped, so that
+ * tests can provoke a failed access using a small address.
+ */
+static bool is_mapped(void const * p) {
+  return reinterpret_cast<uintptr_t>(p) >= 4096;
+}
+
 Maybe<Word> uload(Word const * p) {
+  if (!is_mapped(p)) return nothing;
   return *p;
 }
 
 Maybe<Byte> uload(Byte const * p) {
+  if (!is_mapped(p)) return nothing;
   return *p;
 }
 
 bool ustore(Word * addr, Word value) {
+  if (!is_mapped(addr)) return false;
   *addr = value;
   return true;
 }
 
 bool ustore(Byte * addr, Byte value) {
+  if (!is_mapped(addr)) return false;
   *addr = value;
   return true;
 }
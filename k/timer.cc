@@ -0,0 +1,134 @@
+#include "k/timer.h"
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/become.h"
+#include "k/config.h"
+#include "k/context.h"
+#include "k/reply_sender.h"
+
+namespace k {
+
+template struct ObjectSubclassChecks<Timer, kabi::timer_size>;
+
+// Ticks since boot.
+static uint32_t ticks;
+
+// Armed Timers, hashed by the low bits of their deadlines.
+static List<Timer> wheel[config::n_timer_wheel_slots];
+
+static List<Timer> & wheel_slot_for(uint32_t time) {
+  return wheel[time & (config::n_timer_wheel_slots - 1)];
+}
+
+Timer::Timer(Generation g, Body & body, size_t body_size)
+  : Object{g, Kind::timer}, _body(body), _body_size(body_size) {
+  _body.wheel_item.owner = this;
+}
+
+void Timer::tick() {
+  ++ticks;
+
+  // Timers in this slot are due now, or some multiple of the wheel size
+  // later.  Expire the former and set the latter aside...
+  auto & slot = wheel_slot_for(ticks);
+  List<Timer> later;
+  while (auto t = slot.take()) {
+    auto timer = t.ref();
+    if (timer->_body.deadline == ticks) {
+      timer->expire();
+    } else {
+      later.insert(&timer->_body.wheel_item);
+    }
+  }
+
+  // ...and then put them back.
+  while (auto t = later.take()) {
+    slot.insert(&t.ref()->_body.wheel_item);
+  }
+}
+
+void Timer::expire() {
+  auto target = _body.target.get();
+  if (target->get_kind() == Kind::context) {
+    static_cast<Context *>(target)->interrupt();
+  }
+}
+
+void Timer::deliver_from(Brand const & brand, Sender * sender) {
+  Keys k;
+  Message m = sender->on_delivery(k);
+
+  namespace S = selector::timer;
+  switch (m.desc.get_selector()) {
+    case S::set_target:
+      do_set_target(brand, m, k);
+      break;
+
+    case S::arm:
+      do_arm(brand, m, k);
+      break;
+
+    case S::disarm:
+      do_disarm(brand, m, k);
+      break;
+
+    case S::read_clock:
+      do_read_clock(brand, m, k);
+      break;
+
+    case S::destroy:
+      do_destroy(brand, m, k);
+      break;
+
+    default:
+      do_badop(m, k);
+      break;
+  }
+}
+
+void Timer::do_set_target(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  _body.target = k.keys[1];
+}
+
+void Timer::do_arm(Brand const &, Message const & m, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  auto delay = m.d0;
+  if (delay == 0) {
+    reply_sender.message() = Message::failure(Exception::bad_argument);
+    return;
+  }
+
+  _body.wheel_item.unlink();
+  _body.deadline = ticks + delay;
+  wheel_slot_for(_body.deadline).insert(&_body.wheel_item);
+}
+
+void Timer::do_disarm(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  _body.wheel_item.unlink();
+}
+
+void Timer::do_read_clock(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  reply_sender.message().d0 = ticks;
+}
+
+void Timer::do_destroy(Brand const &, Message const &, Keys & k) {
+  ScopedReplySender reply_sender{k.keys[0]};
+
+  destroy_object(*this, &_body, _body_size, reply_sender);
+  // Note: 'this' may no longer be a Timer.
+}
+
+void Timer::invalidation_hook() {
+  _body.wheel_item.unlink();
+}
+
+}  // namespace k
@@ -0,0 +1,73 @@
+#ifndef K_TIMER_H
+#define K_TIMER_H
+
+/*
+ * Imposes a deadline on a Context's blocking IPC.
+ *
+ * A Timer holds a target key and, when armed, a deadline expressed in kernel
+ * ticks.  If the deadline passes while the target is a Context blocked in send
+ * or receive, the operation is cancelled and the Context resumes with an
+ * exception.
+ *
+ * Armed Timers are kept on a hashed timer wheel, indexed by the low bits of
+ * their deadline, so arming and disarming are constant-time.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "k/key.h"
+#include "k/list.h"
+#include "k/object.h"
+
+namespace k {
+
+class Timer final : public Object {
+public:
+  struct Body {
+    List<Timer>::Item wheel_item;
+    Key target{};
+    uint32_t deadline{0};
+
+    Body() : wheel_item{nullptr} {}
+  };
+
+  Timer(Generation g, Body & body, size_t body_size);
+
+  /*
+   * Advances the kernel clock by one tick and expires any Timers whose
+   * deadlines have arrived.  Should be called from the SysTick ISR.
+   *
+   * Time: linear in the number of Timers sharing the current wheel slot.
+   */
+  static void tick();
+
+  /*
+   * Wheel entries are not ordered by priority; all Timers report the same
+   * one.
+   */
+  Priority get_priority() const { return 0; }
+
+  /*
+   * Implementation of Object.
+   */
+  void deliver_from(Brand const &, Sender *) override;
+
+private:
+  Body & _body;
+  size_t _body_size;
+
+  void expire();
+
+  void do_set_target(Brand const &, Message const &, Keys &);
+  void do_arm(Brand const &, Message const &, Keys &);
+  void do_disarm(Brand const &, Message const &, Keys &);
+  void do_read_clock(Brand const &, Message const &, Keys &);
+  void do_destroy(Brand const &, Message const &, Keys &);
+
+  void invalidation_hook() override;
+};
+
+}  // namespace k
+
+#endif  // K_TIMER_H
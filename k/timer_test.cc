@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+#include "common/abi_sizes.h"
+#include "common/selectors.h"
+
+#include "k/config.h"
+#include "k/context.h"
+#include "k/gate.h"
+#include "k/null_object.h"
+#include "k/object_table.h"
+#include "k/reply_sender.h"
+#include "k/scheduler.h"
+#include "k/timer.h"
+
+#include "k/testutil/spy.h"
+
+namespace k {
+
+namespace S = selector::timer;
+
+class TimerTest : public ::testing::Test {
+protected:
+  ObjectTable::Entry _entries[5];
+
+  Context::Body _fake_context_body;
+  Context _fake_context{0, _fake_context_body,
+                        sizeof(_fake_context_body)};
+
+  // The target starts out null, so expiry has no effect beyond leaving the
+  // wheel.
+  Timer::Body _timer_body;
+
+  // A Context for the Timer to target, and a Gate for it to block on.
+  Context::Body _target_body;
+  Gate::Body _gate_body;
+
+  Spy _spy{0, Object::Kind::context};
+  ReplySender _sender;
+
+  void SetUp() override {
+    new (&_entries[0]) NullObject{0};
+
+    {
+      auto o = new(&_entries[1]) ObjectTable{0};
+      set_object_table(o);
+      o->set_entries(_entries);
+    }
+
+    new(&_entries[2]) Timer{0, _timer_body, sizeof(_timer_body)};
+    new(&_entries[3]) Context{0, _target_body, sizeof(_target_body)};
+    new(&_entries[4]) Gate{0, _gate_body, sizeof(_gate_body)};
+
+    current = &_fake_context;
+  }
+
+  void TearDown() override {
+    // The wheel outlives the test; don't leave our Timer on it.
+    _timer_body.wheel_item.unlink();
+    // Likewise the run queue.
+    _target_body.ctx_item.unlink();
+    _target_body.sender_item.unlink();
+    current = nullptr;
+    reset_object_table_for_test();
+  }
+
+  Object & object() {
+    return _entries[2].as_object();
+  }
+
+  Message const & send_from_spy(Message m) {
+    auto count = _spy.count();
+
+    _sender.message() = m;
+    _sender.set_key(0, _spy.make_key(0).ref());
+    object().deliver_from(0, &_sender);
+
+    EXPECT_EQ(count + 1, _spy.count()) << "single reply should be sent";
+
+    return _spy.message().m;
+  }
+
+  uint32_t read_clock() {
+    return send_from_spy({Descriptor::call(S::read_clock, 0)}).d0;
+  }
+
+  Context & target() {
+    return *static_cast<Context *>(&_entries[3].as_object());
+  }
+
+  // Aims the Timer at the target Context and lets it expire.
+  void expire_at_target() {
+    _sender.set_key(1, target().make_key(0).ref());
+    send_from_spy({Descriptor::call(S::set_target, 0)});
+    _sender.set_key(1, Key::null());
+
+    send_from_spy({Descriptor::call(S::arm, 0), 1});
+    Timer::tick();
+    ASSERT_FALSE(_timer_body.wheel_item.is_linked());
+  }
+};
+
+#define ASSERT_MESSAGE_SUCCESS(__m) \
+  ASSERT_EQ(0, uint32_t((__m).desc))
+
+#define ASSERT_RETURNED_EXCEPTION(_m, _e) \
+{ \
+  auto & __m = (_m); \
+  auto __e = (_e); \
+  ASSERT_TRUE(__m.desc.get_error()) \
+    << "operation should have failed"; \
+  ASSERT_EQ(uint64_t(__e), (uint64_t(__m.d1) << 32) | __m.d0) \
+    << "operation failed with wrong exception"; \
+}
+
+/*
+ * Read Clock
+ */
+
+TEST_F(TimerTest, read_clock) {
+  auto before = read_clock();
+  Timer::tick();
+  Timer::tick();
+  ASSERT_EQ(before + 2, read_clock());
+}
+
+/*
+ * Arm
+ */
+
+TEST_F(TimerTest, arm_zero) {
+  auto & m = send_from_spy({Descriptor::call(S::arm, 0), 0});
+  ASSERT_RETURNED_EXCEPTION(m, Exception::bad_argument);
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked());
+}
+
+TEST_F(TimerTest, arm_expires_on_deadline) {
+  auto & m = send_from_spy({Descriptor::call(S::arm, 0), 3});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_TRUE(_timer_body.wheel_item.is_linked());
+
+  Timer::tick();
+  Timer::tick();
+  ASSERT_TRUE(_timer_body.wheel_item.is_linked())
+    << "Timer should not expire early";
+
+  Timer::tick();
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked())
+    << "Timer should expire at its deadline";
+}
+
+TEST_F(TimerTest, arm_past_wheel_size) {
+  // This deadline shares a wheel slot with the very next tick, so the Timer
+  // is visited once before it's due and must be put back.
+  auto delay = config::n_timer_wheel_slots + 1;
+  auto & m = send_from_spy({Descriptor::call(S::arm, 0), delay});
+  ASSERT_MESSAGE_SUCCESS(m);
+
+  Timer::tick();
+  ASSERT_TRUE(_timer_body.wheel_item.is_linked())
+    << "Timer not yet due should stay on the wheel";
+
+  for (unsigned i = 1; i < delay - 1; ++i) Timer::tick();
+  ASSERT_TRUE(_timer_body.wheel_item.is_linked());
+
+  Timer::tick();
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked());
+}
+
+TEST_F(TimerTest, rearm_replaces_deadline) {
+  send_from_spy({Descriptor::call(S::arm, 0), 1});
+  send_from_spy({Descriptor::call(S::arm, 0), 2});
+
+  Timer::tick();
+  ASSERT_TRUE(_timer_body.wheel_item.is_linked())
+    << "old deadline should have been forgotten";
+
+  Timer::tick();
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked());
+}
+
+/*
+ * Expiry
+ */
+
+TEST_F(TimerTest, expire_sending) {
+  // As if blocked in send to the Gate.
+  _gate_body.senders.insert(&_target_body.sender_item);
+  _target_body.state = Context::State::sending;
+
+  expire_at_target();
+
+  ASSERT_FALSE(_target_body.sender_item.is_linked())
+    << "target should leave the Gate's senders";
+  ASSERT_TRUE(_gate_body.senders.is_empty());
+  ASSERT_EQ(Context::State::runnable, _target_body.state);
+  ASSERT_RETURNED_EXCEPTION(_target_body.save.sys.m, Exception::would_block);
+}
+
+TEST_F(TimerTest, expire_receiving) {
+  target().block_in_receive(_gate_body.receivers);
+  auto brand = _target_body.expected_reply_brand;
+
+  expire_at_target();
+
+  ASSERT_TRUE(_gate_body.receivers.is_empty())
+    << "target should leave the Gate's receivers";
+  ASSERT_EQ(Context::State::runnable, _target_body.state);
+  ASSERT_TRUE(_target_body.ctx_item.is_linked())
+    << "target should be on the run queue";
+  ASSERT_RETURNED_EXCEPTION(_target_body.save.sys.m, Exception::would_block);
+  ASSERT_EQ(brand, _target_body.expected_reply_brand)
+    << "a receive that wasn't awaiting a reply shouldn't revoke reply keys";
+}
+
+TEST_F(TimerTest, expire_awaiting_reply) {
+  // As if blocked in call, with the callee holding our reply key.
+  _target_body.state = Context::State::receiving;
+  auto reply_key =
+    target().make_key(_target_body.expected_reply_brand).ref();
+
+  expire_at_target();
+
+  ASSERT_EQ(Context::State::runnable, _target_body.state);
+  ASSERT_RETURNED_EXCEPTION(_target_body.save.sys.m, Exception::would_block);
+  ASSERT_NE(reply_key.get_brand(), _target_body.expected_reply_brand)
+    << "callee's reply key should have gone stale";
+}
+
+TEST_F(TimerTest, expire_runnable) {
+  target().make_runnable();
+  _target_body.save.sys.m = Message{Descriptor::zero(), 42};
+
+  expire_at_target();
+
+  ASSERT_EQ(Context::State::runnable, _target_body.state);
+  ASSERT_TRUE(_target_body.ctx_item.is_linked());
+  ASSERT_EQ(42, _target_body.save.sys.m.d0)
+    << "a running Context's registers should be left alone";
+}
+
+TEST_F(TimerTest, expire_stopped) {
+  auto brand = _target_body.expected_reply_brand;
+
+  expire_at_target();
+
+  ASSERT_EQ(Context::State::stopped, _target_body.state);
+  ASSERT_FALSE(_target_body.ctx_item.is_linked());
+  ASSERT_EQ(brand, _target_body.expected_reply_brand);
+}
+
+/*
+ * Disarm
+ */
+
+TEST_F(TimerTest, disarm) {
+  send_from_spy({Descriptor::call(S::arm, 0), 1});
+
+  auto & m = send_from_spy({Descriptor::call(S::disarm, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked());
+
+  Timer::tick();  // shouldn't care that we're gone
+}
+
+/*
+ * Destroy
+ */
+
+TEST_F(TimerTest, destroy_armed) {
+  send_from_spy({Descriptor::call(S::arm, 0), 1});
+
+  auto & m = send_from_spy({Descriptor::call(S::destroy, 0)});
+  ASSERT_MESSAGE_SUCCESS(m);
+  ASSERT_FALSE(_timer_body.wheel_item.is_linked())
+    << "a destroyed Timer must leave the wheel";
+
+  ASSERT_EQ(Object::Kind::memory, object().get_kind());
+  ASSERT_EQ(&object(), _spy.keys().keys[1].get());
+
+  Timer::tick();  // shouldn't care that we're gone
+}
+
+}  // namespace k
+
+int main(int argc, char * argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -6,7 +6,4 @@
   }
 
 TRAP(nmi)
-TRAP(hard_fault)
-TRAP(bus_fault)
-TRAP(usage_fault)
 TRAP(debug_monitor)